@@ -0,0 +1,158 @@
+/**
+ * Host implementations of the ESP-IDF / FreeRTOS calls the driver makes,
+ * on a virtual clock. Single-threaded: the caller is the only task.
+ */
+
+#include "host_port.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define US_PER_TICK (1000000LL / configTICK_RATE_HZ)
+
+static int64_t s_now_us = 0;
+
+int64_t host_clock_now_us(void)
+{
+    return s_now_us;
+}
+
+void host_clock_advance_us(int64_t us)
+{
+    if (us > 0) {
+        s_now_us += us;
+    }
+}
+
+void host_clock_advance_to_us(int64_t t_us)
+{
+    if (t_us > s_now_us) {
+        s_now_us = t_us;
+    }
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    s_now_us += us;
+}
+
+/* Like the real scheduler, a delay ends on a tick boundary */
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0) {
+        return;   /* A yield; rounding down would turn the clock back */
+    }
+    s_now_us = (s_now_us / US_PER_TICK + ticks) * US_PER_TICK;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(s_now_us / US_PER_TICK);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    (void)task;
+    (void)woken;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio,
+                       TaskHandle_t *handle)
+{
+    (void)fn;
+    (void)name;
+    (void)stack;
+    (void)arg;
+    (void)prio;
+    if (handle) {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buf)
+{
+    *buf = (StaticSemaphore_t){ .count = 0, .max = 1 };
+    return buf;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buf)
+{
+    *buf = (StaticSemaphore_t){ .count = 1, .max = 1 };
+    return buf;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *buf)
+{
+    *buf = (StaticSemaphore_t){ .count = (int)initial, .max = (int)max };
+    return buf;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (sem->count > 0) {
+        sem->count--;
+        return pdTRUE;
+    }
+    if (ticks != portMAX_DELAY) {
+        vTaskDelay(ticks);
+    }
+    return pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count >= sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    (void)woken;
+    return xSemaphoreGive(sem);
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg)
+{
+    (void)cfg;
+    return ESP_OK;
+}
+
+/* No ISR service: the driver falls back to polling, as on a board without IRQ wired */
+esp_err_t gpio_install_isr_service(int flags)
+{
+    (void)flags;
+    return ESP_FAIL;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, void (*isr)(void *), void *arg)
+{
+    (void)pin;
+    (void)isr;
+    (void)arg;
+    return ESP_FAIL;
+}
+
+int gpio_get_level(gpio_num_t pin)
+{
+    (void)pin;
+    return 1;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level)
+{
+    (void)pin;
+    (void)level;
+    return ESP_OK;
+}
@@ -0,0 +1,17 @@
+/**
+ * Virtual clock behind the host shims. Nothing sleeps on the host: delays,
+ * semaphore waits and simulated bus transfers advance the clock instead, so
+ * a run is deterministic and takes milliseconds of real time.
+ */
+
+#ifndef HOST_PORT_H
+#define HOST_PORT_H
+
+#include <stdint.h>
+
+int64_t host_clock_now_us(void);
+void host_clock_advance_us(int64_t us);
+/* Jump forward to t_us; no-op if the clock is already past it */
+void host_clock_advance_to_us(int64_t t_us);
+
+#endif /* HOST_PORT_H */
@@ -0,0 +1,268 @@
+/**
+ * NDEF parser tests on canned tag dumps (TECHNICAL_DOCUMENTATION.md §10.4, §19).
+ * Type 2 dumps start at page 3 (CC, then the data area); Type 4 dumps are the
+ * NDEF file (NLEN, then the message). Exit status 1 if any check fails.
+ */
+
+#include "ndef.h"
+#include <stdio.h>
+#include <string.h>
+
+static int s_failures;
+static int s_checks;
+
+static void check(bool ok, const char *what)
+{
+    s_checks++;
+    if (!ok) {
+        printf("  FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static bool view_is(ndef_view_t v, const char *s)
+{
+    return v.len == strlen(s) && memcmp(v.ptr, s, v.len) == 0;
+}
+
+/* NTAG213 with one URI record: CC, then 03 10 D1 01 0C 55 01 "example.com" FE */
+static const uint8_t NTAG213_URI[] = {
+    0xE1, 0x10, 0x12, 0x00,
+    0x03, 0x10, 0xD1, 0x01, 0x0C, 0x55, 0x01, 'e', 'x', 'a', 'm', 'p', 'l', 'e', '.', 'c', 'o', 'm',
+    0xFE, 0x00,
+};
+
+static void test_cc(void)
+{
+    ndef_cc_t cc;
+    printf("Capability Container\n");
+    check(ndef_parse_cc(NTAG213_URI, &cc) == NDEF_OK && cc.version == 0x10 && cc.data_area_size == 144 &&
+          cc.access == 0x00, "NTAG213 CC");
+
+    static const uint8_t ntag216[] = { 0xE1, 0x10, 0x6D, 0x00 };
+    check(ndef_parse_cc(ntag216, &cc) == NDEF_OK && cc.data_area_size == 872, "NTAG216 CC");
+
+    static const uint8_t bad_magic[] = { 0xE2, 0x10, 0x12, 0x00 };
+    check(ndef_parse_cc(bad_magic, &cc) == NDEF_ERR_FORMAT, "CC magic other than E1");
+
+    static const uint8_t v2[] = { 0xE1, 0x20, 0x12, 0x00 };
+    check(ndef_parse_cc(v2, &cc) == NDEF_ERR_FORMAT, "CC major version 2");
+}
+
+static void test_short_message(void)
+{
+    const uint8_t *data = NTAG213_URI + NDEF_CC_LEN;
+    size_t len = sizeof(NTAG213_URI) - NDEF_CC_LEN;
+    ndef_view_t msg;
+    size_t needed = 0;
+    printf("NTAG213, one URI record\n");
+    check(ndef_find_message(data, len, &msg, &needed) == NDEF_OK && msg.ptr == data + 2 && msg.len == 16 &&
+          needed == 18, "message TLV with 1-byte length");
+
+    ndef_reader_t reader;
+    ndef_record_t rec;
+    ndef_reader_init(&reader, msg);
+    const uint8_t flags = NDEF_FLAG_MB | NDEF_FLAG_ME | NDEF_FLAG_SR;
+    check(ndef_next_record(&reader, &rec) == NDEF_OK && rec.tnf == NDEF_TNF_WELL_KNOWN &&
+          (rec.header & flags) == flags &&
+          view_is(rec.type, "U") && rec.id.len == 0 && rec.payload.len == 12 && rec.payload.ptr[0] == 0x01 &&
+          memcmp(rec.payload.ptr + 1, "example.com", 11) == 0, "SR URI record");
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_END, "end after the ME record");
+}
+
+/* Lock control, NULL and proprietary TLVs ahead of the message are skipped */
+static void test_skipped_tlvs(void)
+{
+    static const uint8_t data[] = {
+        0x01, 0x03, 0xA0, 0x0C, 0x34,   /* Lock control */
+        0x00, 0x00,                     /* NULL */
+        0xFD, 0x00,                     /* Proprietary, zero length */
+        0x03, 0x03, 0xD0, 0x00, 0x00,   /* Empty record */
+        0xFE,
+    };
+    ndef_view_t msg;
+    size_t needed = 0;
+    printf("TLVs before the message\n");
+    check(ndef_find_message(data, sizeof(data), &msg, &needed) == NDEF_OK && msg.ptr == data + 11 &&
+          msg.len == 3 && needed == 14, "lock, NULL and zero-length proprietary TLVs skipped");
+
+    ndef_reader_t reader;
+    ndef_record_t rec;
+    ndef_reader_init(&reader, msg);
+    check(ndef_next_record(&reader, &rec) == NDEF_OK && rec.tnf == NDEF_TNF_EMPTY && rec.type.len == 0 &&
+          rec.payload.len == 0, "empty record");
+
+    static const uint8_t terminated[] = { 0x01, 0x03, 0xA0, 0x0C, 0x34, 0xFE, 0x03, 0x00 };
+    check(ndef_find_message(terminated, sizeof(terminated), &msg, &needed) == NDEF_ERR_NOT_FOUND,
+          "terminator before any message TLV");
+}
+
+/* Zero-length message TLV: a formatted but empty tag */
+static void test_empty_message(void)
+{
+    static const uint8_t data[] = { 0x03, 0x00, 0xFE };
+    ndef_view_t msg;
+    size_t needed = 0;
+    printf("Zero-length message TLV\n");
+    check(ndef_find_message(data, sizeof(data), &msg, &needed) == NDEF_OK && msg.len == 0 && needed == 2,
+          "03 00 is an empty message");
+
+    ndef_reader_t reader;
+    ndef_record_t rec;
+    ndef_reader_init(&reader, msg);
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_END, "no records in an empty message");
+}
+
+/*
+ * NTAG216 with a 300-byte message: 3-byte TLV length, one long (non-SR) MIME
+ * record. Also fed in pieces, as read_tag_ndef() gets it: the 12 bytes after
+ * the CC from READ page 3, then exactly up to *needed.
+ */
+static void test_long_message(void)
+{
+    static uint8_t data[4 + 300 + 1];
+    const size_t payload_len = 300 - 16;
+    size_t n = 0;
+    data[n++] = NDEF_TLV_MESSAGE;
+    data[n++] = 0xFF;
+    data[n++] = 0x01;
+    data[n++] = 0x2C;
+    data[n++] = NDEF_FLAG_MB | NDEF_FLAG_ME | NDEF_TNF_MIME_MEDIA;
+    data[n++] = 10;
+    data[n++] = 0x00;
+    data[n++] = 0x00;
+    data[n++] = (uint8_t)(payload_len >> 8);
+    data[n++] = (uint8_t)payload_len;
+    memcpy(data + n, "text/plain", 10);
+    n += 10;
+    for (size_t i = 0; i < payload_len; i++) {
+        data[n++] = (uint8_t)('a' + i % 26);
+    }
+    data[n++] = NDEF_TLV_TERMINATOR;
+
+    ndef_view_t msg;
+    size_t needed = 0;
+    printf("NTAG216, 300-byte message\n");
+    check(ndef_find_message(data, 1, &msg, &needed) == NDEF_ERR_INCOMPLETE && needed == 2,
+          "TLV type only: needs the length byte");
+    check(ndef_find_message(data, 2, &msg, &needed) == NDEF_ERR_INCOMPLETE && needed == 4,
+          "FF marker: needs the 2-byte length");
+    check(ndef_find_message(data, 12, &msg, &needed) == NDEF_ERR_INCOMPLETE && needed == 304,
+          "first READ: needs the whole 3-byte-length TLV");
+    check(ndef_find_message(data, 303, &msg, &needed) == NDEF_ERR_INCOMPLETE && needed == 304,
+          "one byte short");
+    check(ndef_find_message(data, sizeof(data), &msg, &needed) == NDEF_OK && msg.ptr == data + 4 &&
+          msg.len == 300 && needed == 304, "complete message");
+
+    ndef_reader_t reader;
+    ndef_record_t rec;
+    ndef_reader_init(&reader, msg);
+    check(ndef_next_record(&reader, &rec) == NDEF_OK && rec.tnf == NDEF_TNF_MIME_MEDIA &&
+          !(rec.header & NDEF_FLAG_SR) && view_is(rec.type, "text/plain") &&
+          rec.payload.len == payload_len && rec.payload.ptr == data + 20 &&
+          rec.payload.ptr[payload_len - 1] == (uint8_t)('a' + (payload_len - 1) % 26),
+          "long record, 4-byte payload length");
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_END, "end after the long record");
+
+    /* Round trip through the writer's TLV builder */
+    static uint8_t built[sizeof(data)];
+    size_t built_len = 0;
+    check(ndef_build_tlv(msg.ptr, msg.len, built, sizeof(built), &built_len) == NDEF_OK &&
+          built_len == sizeof(data) && memcmp(built, data, sizeof(data)) == 0,
+          "ndef_build_tlv, 3-byte length");
+}
+
+/* Type 4 NDEF file: NLEN, then two SR records, the first with an ID (IL) */
+static void test_type4(void)
+{
+    static const uint8_t file[] = {
+        0x00, 0x14,
+        NDEF_FLAG_MB | NDEF_FLAG_SR | NDEF_FLAG_IL | NDEF_TNF_WELL_KNOWN, 0x01, 0x06, 0x02, 'T', 'i', 'd',
+        0x02, 'e', 'n', 'h', 'i', '!',
+        NDEF_FLAG_ME | NDEF_FLAG_SR | NDEF_TNF_EXTERNAL, 0x03, 0x01, 'a', ':', 'b', 0x2A,
+    };
+    ndef_view_t msg = { file + 2, ((size_t)file[0] << 8) | file[1] };
+    ndef_reader_t reader;
+    ndef_record_t rec;
+    printf("Type 4 NDEF file, two records\n");
+    check(msg.len == sizeof(file) - 2, "NLEN matches the dump");
+    ndef_reader_init(&reader, msg);
+    check(ndef_next_record(&reader, &rec) == NDEF_OK && (rec.header & NDEF_FLAG_IL) &&
+          view_is(rec.type, "T") && view_is(rec.id, "id") && rec.payload.len == 6 &&
+          memcmp(rec.payload.ptr, "\x02" "enhi!", 6) == 0,
+          "SR record with IL");
+    check(ndef_next_record(&reader, &rec) == NDEF_OK && rec.tnf == NDEF_TNF_EXTERNAL &&
+          view_is(rec.type, "a:b") && rec.id.len == 0 && rec.payload.len == 1 && rec.payload.ptr[0] == 0x2A,
+          "second record");
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_END, "end after the ME record");
+}
+
+/* Lengths that run past the message must fail, never read beyond it */
+static void test_malformed(void)
+{
+    ndef_reader_t reader;
+    ndef_record_t rec;
+    printf("Truncated and overflowing records\n");
+
+    static const uint8_t header_only[] = { 0xD1, 0x01 };
+    ndef_reader_init(&reader, (ndef_view_t){ header_only, sizeof(header_only) });
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "SR header cut before the payload length");
+
+    static const uint8_t long_header[] = { 0xC1, 0x01, 0x00, 0x00, 0x01 };
+    ndef_reader_init(&reader, (ndef_view_t){ long_header, sizeof(long_header) });
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "long header cut inside the payload length");
+
+    static const uint8_t il_header[] = { 0xD9, 0x01, 0x00 };
+    ndef_reader_init(&reader, (ndef_view_t){ il_header, sizeof(il_header) });
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "IL header cut before the ID length");
+
+    static const uint8_t payload_over[] = { 0xD1, 0x01, 0x05, 'T', 0x02, 'e', 'n' };
+    ndef_reader_init(&reader, (ndef_view_t){ payload_over, sizeof(payload_over) });
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "payload length past the message");
+
+    static const uint8_t type_over[] = { 0xD1, 0x09, 0x00, 'T' };
+    ndef_reader_init(&reader, (ndef_view_t){ type_over, sizeof(type_over) });
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "type length past the message");
+
+    static const uint8_t id_over[] = { 0xD9, 0x01, 0x00, 0x04, 'T', 'i' };
+    ndef_reader_init(&reader, (ndef_view_t){ id_over, sizeof(id_over) });
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "ID length past the message");
+
+    /* 0xFFFFFFFF would wrap a naive pos + type + id + payload sum */
+    static const uint8_t payload_wrap[] = { 0xC1, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 'T', 0x00 };
+    ndef_reader_init(&reader, (ndef_view_t){ payload_wrap, sizeof(payload_wrap) });
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "4-byte payload length 0xFFFFFFFF");
+
+    /* Second record truncated: the first still parses */
+    static const uint8_t second_cut[] = { 0x91, 0x01, 0x01, 'T', 0x00, 0x51, 0x01, 0x04, 'T', 0x00 };
+    ndef_reader_init(&reader, (ndef_view_t){ second_cut, sizeof(second_cut) });
+    check(ndef_next_record(&reader, &rec) == NDEF_OK && rec.payload.len == 1,
+          "record before a truncated one");
+    check(ndef_next_record(&reader, &rec) == NDEF_ERR_FORMAT, "truncated second record");
+
+    /* 3-byte TLV length larger than the tag's data area stays INCOMPLETE with the true size */
+    static const uint8_t tlv_over[] = { 0x03, 0xFF, 0xFF, 0xF0, 0xD1 };
+    ndef_view_t msg;
+    size_t needed = 0;
+    check(ndef_find_message(tlv_over, sizeof(tlv_over), &msg, &needed) == NDEF_ERR_INCOMPLETE &&
+          needed == 4 + 0xFFF0, "TLV length beyond any tag");
+
+    uint8_t small[8];
+    size_t out_len = 0;
+    check(ndef_build_tlv(second_cut, sizeof(second_cut), small, sizeof(small), &out_len) == NDEF_ERR_FORMAT,
+          "ndef_build_tlv into a buffer too small");
+}
+
+int main(void)
+{
+    test_cc();
+    test_short_message();
+    test_skipped_tlvs();
+    test_empty_message();
+    test_long_message();
+    test_type4();
+    test_malformed();
+
+    printf("\n%d checks, %s\n", s_checks, s_failures ? "FAILED" : "OK");
+    return s_failures ? 1 : 0;
+}
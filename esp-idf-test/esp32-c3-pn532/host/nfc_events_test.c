@@ -0,0 +1,186 @@
+/**
+ * Event dispatcher tests (TECHNICAL_DOCUMENTATION.md §12.5, §19). The host
+ * shim never runs the consumer task, so each test posts from "the polling
+ * task" and then drains the ring with nfc_events_dispatch(). Exit status 1
+ * if any check fails.
+ */
+
+#include "host_port.h"
+#include "nfc_events.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_MAX_DELIVERED  32
+
+static int s_failures;
+static int s_checks;
+
+static nfc_event_t s_delivered[TEST_MAX_DELIVERED];
+static unsigned s_delivered_count;
+
+static void check(bool ok, const char *what)
+{
+    s_checks++;
+    if (!ok) {
+        printf("  FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static void record(const nfc_event_t *ev, void *ctx)
+{
+    (void)ctx;
+    if (s_delivered_count < TEST_MAX_DELIVERED) {
+        s_delivered[s_delivered_count] = *ev;
+    }
+    s_delivered_count++;
+    host_clock_advance_us(1000);   /* A handler that takes a while */
+}
+
+static void reset(void)
+{
+    s_delivered_count = 0;
+    check(nfc_events_start(record, NULL), "nfc_events_start");
+}
+
+/* Tag with a one-byte distinguishing UID */
+static void post(nfc_event_kind_t kind, uint8_t id)
+{
+    pn532_tag_info_t tag = { .uid = { 0x04, id, 0x22, 0x33 }, .uid_length = 4, .sak = 0x00,
+                             .type = PN532_TAG_MIFARE_ULTRALIGHT };
+    nfc_event_t ev;
+    nfc_event_init(&ev, kind, &tag);
+    nfc_events_post(&ev);
+    host_clock_advance_us(100);
+}
+
+static unsigned drain(void)
+{
+    unsigned n = 0;
+    while (nfc_events_dispatch(0)) {
+        n++;
+    }
+    return n;
+}
+
+static bool delivered_is(unsigned i, nfc_event_kind_t kind, uint8_t id)
+{
+    return i < s_delivered_count && s_delivered[i].kind == kind && s_delivered[i].uid_length == 4 &&
+           s_delivered[i].uid[1] == id;
+}
+
+static void test_empty(void)
+{
+    printf("Empty ring\n");
+    reset();
+    check(!nfc_events_dispatch(0), "dispatch with nothing pending returns false");
+    check(s_delivered_count == 0, "handler not called");
+}
+
+/* Repeats of the same event while it is pending merge into it */
+static void test_coalescing(void)
+{
+    nfc_events_stats_t st;
+    printf("Coalescing\n");
+    reset();
+    post(NFC_EVENT_TAG_DETECTED, 1);
+    int64_t first_us = host_clock_now_us() - 100;
+    post(NFC_EVENT_TAG_DETECTED, 1);
+    post(NFC_EVENT_TAG_DETECTED, 1);
+    post(NFC_EVENT_TAG_DETECTED, 2);
+    post(NFC_EVENT_TAG_DETECTED, 1);   /* Newest pending for UID 1 is still the first event */
+    check(drain() == 2, "two events delivered");
+    check(delivered_is(0, NFC_EVENT_TAG_DETECTED, 1) && s_delivered[0].repeats == 3 &&
+          s_delivered[0].timestamp_us == first_us, "UID 1: one event, 3 repeats, first timestamp");
+    check(delivered_is(1, NFC_EVENT_TAG_DETECTED, 2) && s_delivered[1].repeats == 0, "UID 2: one event");
+    nfc_events_get_stats(&st);
+    check(st.posted == 5 && st.coalesced == 3 && st.delivered == 2 && st.overflows == 0 && st.high_water == 2,
+          "stats: 5 posted, 3 coalesced, 2 delivered");
+}
+
+/* A different kind for the same UID never merges across it, so the order is kept */
+static void test_order(void)
+{
+    static const nfc_event_kind_t kinds[] = {
+        NFC_EVENT_TAG_DETECTED, NFC_EVENT_NDEF_MESSAGE, NFC_EVENT_TAG_REMOVED,
+        NFC_EVENT_TAG_DETECTED, NFC_EVENT_TAG_REMOVED,
+    };
+    printf("Order for one UID\n");
+    reset();
+    for (unsigned i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        post(kinds[i], 7);
+    }
+    check(drain() == 5, "all five delivered");
+    bool in_order = true;
+    for (unsigned i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        in_order &= delivered_is(i, kinds[i], 7) && s_delivered[i].repeats == 0;
+    }
+    check(in_order, "DETECTED, NDEF, REMOVED, DETECTED, REMOVED in posting order");
+
+    /* REMOVED then DETECTED again while the first DETECTED is still pending */
+    reset();
+    post(NFC_EVENT_TAG_DETECTED, 7);
+    post(NFC_EVENT_TAG_REMOVED, 7);
+    post(NFC_EVENT_TAG_DETECTED, 7);
+    post(NFC_EVENT_TAG_REMOVED, 7);
+    post(NFC_EVENT_TAG_REMOVED, 7);
+    check(drain() == 4, "re-tap delivered as its own pair");
+    check(delivered_is(0, NFC_EVENT_TAG_DETECTED, 7) && delivered_is(1, NFC_EVENT_TAG_REMOVED, 7) &&
+          delivered_is(2, NFC_EVENT_TAG_DETECTED, 7) && delivered_is(3, NFC_EVENT_TAG_REMOVED, 7) &&
+          s_delivered[3].repeats == 1, "D R D R, the last REMOVED with 1 repeat");
+}
+
+/* A full ring drops its oldest event; the newest state always gets through */
+static void test_overflow(void)
+{
+    nfc_events_stats_t st;
+    const unsigned extra = 3;
+    printf("Full ring\n");
+    reset();
+    for (unsigned i = 0; i < NFC_EVENTS_QUEUE_LEN + extra; i++) {
+        post(NFC_EVENT_TAG_DETECTED, (uint8_t)(0x10 + i));
+    }
+    check(drain() == NFC_EVENTS_QUEUE_LEN, "a full ring's worth delivered");
+    bool newest = true;
+    for (unsigned i = 0; i < NFC_EVENTS_QUEUE_LEN; i++) {
+        newest &= delivered_is(i, NFC_EVENT_TAG_DETECTED, (uint8_t)(0x10 + extra + i));
+    }
+    check(newest, "the oldest events were dropped, the rest in order");
+    nfc_events_get_stats(&st);
+    check(st.overflows == extra && st.high_water == NFC_EVENTS_QUEUE_LEN &&
+          st.delivered == NFC_EVENTS_QUEUE_LEN, "stats: overflows and high water");
+    check(!nfc_events_dispatch(0), "pending count matches the ring after drops");
+
+    /* The ring keeps working after wrapping */
+    post(NFC_EVENT_TAG_REMOVED, 0x42);
+    check(drain() == 1 && delivered_is(NFC_EVENTS_QUEUE_LEN, NFC_EVENT_TAG_REMOVED, 0x42),
+          "post after an overflow");
+}
+
+/* The consumer's timing counters */
+static void test_stats(void)
+{
+    nfc_events_stats_t st;
+    printf("Wait and handler time\n");
+    reset();
+    post(NFC_EVENT_TAG_DETECTED, 1);
+    host_clock_advance_us(5000);
+    check(drain() == 1, "delivered");
+    nfc_events_get_stats(&st);
+    check(st.max_wait_us == 5100 && st.max_handler_us == 1000, "max wait 5.1 ms, max handler 1 ms");
+    nfc_events_reset_stats();
+    nfc_events_get_stats(&st);
+    check(st.posted == 0 && st.delivered == 0 && st.max_wait_us == 0, "reset");
+}
+
+int main(void)
+{
+    test_empty();
+    test_coalescing();
+    test_order();
+    test_overflow();
+    test_stats();
+
+    printf("\n%d checks, %s\n", s_checks, s_failures ? "FAILED" : "OK");
+    return s_failures ? 1 : 0;
+}
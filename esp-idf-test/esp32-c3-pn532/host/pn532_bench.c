@@ -0,0 +1,751 @@
+/**
+ * Driver benchmark against the simulated PN532 (TECHNICAL_DOCUMENTATION.md §19).
+ * All times are virtual: they follow the simulator's latency model and the
+ * driver's own waits, not the speed of the host. Exit status 1 if a data
+ * check fails or the driver returns an error where none is expected.
+ *
+ * Usage: pn532_bench [-s seed] [-n tags] [-b bus_us_per_byte]
+ */
+
+#include "host_port.h"
+#include "nfc_cadence.h"
+#include "nfc_sched.h"
+#include "pn532.h"
+#include "pn532_sim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Same RF settings as nfc_init() in main.c */
+#define BENCH_PASSIVE_RETRIES   0x01
+#define BENCH_NONDEP_TIMEOUT    0x09
+
+#define BENCH_ROUNDS            100
+#define BENCH_MAX_TAGS          1000
+#define BENCH_ARRIVAL_MAX_MS    2000   /* Tags arrive 0..2 s after the previous one left */
+#define BENCH_DWELL_MS          3000   /* Tags not listed by then count as missed */
+#define BENCH_HIST_BUCKET_MS    100
+#define BENCH_HIST_BUCKETS      20
+#define BENCH_HIST_WIDTH        50
+
+/* NTAG216: 231 pages, user memory pages 4..225 (888 bytes) */
+#define BENCH_NTAG_PAGES        231
+#define BENCH_NTAG_FIRST_PAGE   4
+#define BENCH_NTAG_USER_PAGES   222
+#define BENCH_NTAG_USER_LEN     (BENCH_NTAG_USER_PAGES * PN532_NTAG_PAGE_SIZE)
+
+/* Cadence (doc §12.6): taps in bursts, 60% 0..3 s after the last one, else 30..300 s later */
+#define BENCH_CADENCE_ARRIVALS  100
+#define BENCH_BURST_PCT         60
+#define BENCH_BURST_GAP_MAX_MS  3000
+#define BENCH_IDLE_GAP_MIN_MS   30000
+#define BENCH_IDLE_GAP_MAX_MS   300000
+
+/* Bus recovery (doc §15.4): same streak as NFC_RECOVER_AFTER_ERRORS in main.c */
+#define BENCH_RECOVERY_ROUNDS   50
+#define BENCH_RECOVER_AFTER     2
+#define BENCH_BROWNOUT_MAX_MS   100
+#define BENCH_OUTAGE_POLLS_MAX  100
+
+/* Classic 1K */
+#define BENCH_CLASSIC_SECTORS   16
+#define BENCH_CLASSIC_LEN       (BENCH_CLASSIC_SECTORS * 4 * PN532_MIFARE_BLOCK_SIZE)
+
+typedef struct {
+    int64_t t_us;
+    pn532_sim_stats_t sim;
+} bench_mark_t;
+
+static pn532_dev_t s_dev;
+static uint32_t s_rng;
+static int s_failures;
+
+static uint8_t s_ntag_mem[BENCH_NTAG_PAGES * PN532_NTAG_PAGE_SIZE];
+static uint8_t s_classic_mem[BENCH_CLASSIC_LEN];
+static uint32_t s_latency_us[BENCH_MAX_TAGS];
+
+/* Deterministic for a given -s: xorshift32 */
+static uint32_t rng_next(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void mark(bench_mark_t *m)
+{
+    m->t_us = host_clock_now_us();
+    pn532_sim_get_stats(&m->sim);
+}
+
+/* Report per-operation cost since m; ops > 0 */
+static void report(const char *what, const bench_mark_t *m, unsigned ops)
+{
+    bench_mark_t now;
+    mark(&now);
+    double us = (double)(now.t_us - m->t_us) / ops;
+    double bytes = (double)((now.sim.bytes_written - m->sim.bytes_written) +
+                            (now.sim.bytes_read - m->sim.bytes_read)) / ops;
+    double xfers = (double)(now.sim.transactions - m->sim.transactions) / ops;
+    double cmds = (double)(now.sim.commands - m->sim.commands) / ops;
+    double idle = (double)(now.sim.not_ready_reads - m->sim.not_ready_reads) / ops;
+    printf("  %-26s %9.0f us %7.1f bytes %5.1f cmds %6.1f transactions %5.1f not-ready\n",
+           what, us, bytes, cmds, xfers, idle);
+}
+
+static void check(bool ok, const char *what)
+{
+    if (!ok) {
+        printf("  FAIL: %s\n", what);
+        s_failures++;
+    }
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Attach s_dev over transport, freshly, and configure it like nfc_init() */
+static bool bench_init(pn532_transport_t transport)
+{
+    pn532_config_t cfg = PN532_CONFIG_DEFAULT();
+    cfg.transport = transport;
+    cfg.irq_gpio = -1;
+    cfg.rst_gpio = -1;
+    s_dev = (pn532_dev_t){ 0 };
+    if (pn532_init(&s_dev, &cfg) != PN532_OK) {
+        return false;
+    }
+    pn532_wakeup(&s_dev);
+    return pn532_sam_config(&s_dev) == PN532_OK &&
+           pn532_set_max_retries(&s_dev, PN532_RFCFG_RETRY_FOREVER, 0x01,
+                                 BENCH_PASSIVE_RETRIES) == PN532_OK &&
+           pn532_set_rf_timings(&s_dev, 0x0B, BENCH_NONDEP_TIMEOUT) == PN532_OK;
+}
+
+static void bench_firmware_version(void)
+{
+    bench_mark_t m;
+    pn532_firmware_version_t fw;
+    printf("GetFirmwareVersion x%d\n", BENCH_ROUNDS);
+    mark(&m);
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        check(pn532_get_firmware_version(&s_dev, &fw) == PN532_OK && fw.ic == 0x32, "GetFirmwareVersion");
+    }
+    report("round trip", &m, BENCH_ROUNDS);
+}
+
+/* Async API (doc §8.4): how often the caller's loop checks in; nothing advances the clock otherwise */
+#define BENCH_ASYNC_TICK_US     100
+
+static void bench_async_done(pn532_err_t err, const uint8_t *data, size_t len, void *ctx)
+{
+    bool ok = err == PN532_OK && len >= 2 && data[0] == PN532_RSP_GET_FIRMWARE_VERSION && data[1] == 0x32;
+    *(pn532_err_t *)ctx = ok ? PN532_OK : (err != PN532_OK ? err : PN532_ERR_RESPONSE);
+}
+
+/*
+ * GetFirmwareVersion through pn532_submit()/pn532_process(), rounds times.
+ * Returns the longest pn532_process() call; adds to *calls, sets *nacked if
+ * a two-phase read took the NACKED step.
+ */
+static int64_t async_rounds(int rounds, unsigned *calls, bool *nacked)
+{
+    int64_t max_step_us = 0;
+    for (int i = 0; i < rounds; i++) {
+        pn532_err_t result = PN532_ERR_TIMEOUT;
+        pn532_err_t err = pn532_submit(&s_dev, PN532_CMD_GET_FIRMWARE_VERSION, NULL, 0,
+                                       PN532_RESPONSE_TIMEOUT_MS, bench_async_done, &result);
+        check(err == PN532_OK, "pn532_submit");
+        pn532_async_state_t st = (err == PN532_OK) ? PN532_ASYNC_SENT : PN532_ASYNC_IDLE;
+        while (st != PN532_ASYNC_IDLE) {
+            host_clock_advance_us(BENCH_ASYNC_TICK_US);
+            int64_t t0 = host_clock_now_us();
+            st = pn532_process(&s_dev);
+            int64_t step_us = host_clock_now_us() - t0;
+            if (step_us > max_step_us) {
+                max_step_us = step_us;
+            }
+            *nacked |= (st == PN532_ASYNC_NACKED);
+            (*calls)++;
+        }
+        check(result == PN532_OK, "async GetFirmwareVersion");
+    }
+    return max_step_us;
+}
+
+/* No step may wait for the PN532: the longest call is bounded by its own bus transfers */
+static void bench_async(void)
+{
+    bench_mark_t m;
+    unsigned calls = 0;
+    bool nacked = false;
+    printf("GetFirmwareVersion async x%d, pn532_process() every %d us\n", BENCH_ROUNDS, BENCH_ASYNC_TICK_US);
+    mark(&m);
+    int64_t max_step_us = async_rounds(BENCH_ROUNDS, &calls, &nacked);
+    report("round trip", &m, BENCH_ROUNDS);
+    printf("  %.1f pn532_process() calls per command, longest call %lld us\n",
+           (double)calls / BENCH_ROUNDS, (long long)max_step_us);
+#if PN532_TWO_PHASE_READ
+    check(nacked, "two-phase read took the NACKED step");
+#endif
+}
+
+static void bench_empty_poll(void)
+{
+    bench_mark_t m;
+    pn532_tag_info_t tag;
+    printf("InListPassiveTarget 106A, empty field, x%d\n", BENCH_ROUNDS);
+    mark(&m);
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        pn532_err_t err = pn532_list_passive_target(&s_dev, PN532_BAUDRATE_106K_ISO14443A,
+                                                    PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+        check(err == PN532_ERR_NOT_FOUND, "empty poll");
+    }
+    int64_t us = (host_clock_now_us() - m.t_us) / BENCH_ROUNDS;
+    report("poll", &m, BENCH_ROUNDS);
+    printf("  max %.1f polls/s back to back, bus busy %.1f%% at the %d ms poll interval\n",
+           1e6 / (double)us, 100.0 * (double)us / (PN532_POLL_INTERVAL_MS * 1000.0 + (double)us),
+           PN532_POLL_INTERVAL_MS);
+}
+
+/*
+ * The polling_task() loop without presence probes: the scheduler picks the
+ * modulation, a hit ends the arrival. Latency = tag enters -> list returns.
+ */
+static void bench_detection(unsigned tag_count)
+{
+    static const nfc_sched_config_t sched_cfg = {
+        .modes      = { PN532_BAUDRATE_106K_ISO14443A, PN532_BAUDRATE_106K_ISO14443B,
+                        PN532_BAUDRATE_212K_FELICA },
+        .mode_count = 3,
+        .max_gap    = 6,
+        .min_weight = 64,
+        .rate_shift = 4,
+    };
+    /* One scripted tag per modulation, moved in and out of the field */
+    pn532_sim_tag_t a = { .brty = PN532_BAUDRATE_106K_ISO14443A,
+                          .uid = { 0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 }, .uid_length = 7,
+                          .sak = 0x00, .atqa = { 0x00, 0x44 } };
+    pn532_sim_tag_t b = { .brty = PN532_BAUDRATE_106K_ISO14443B, .uid = { 0xB0, 0xB1, 0xB2, 0xB3 },
+                          .uid_length = 4 };
+    pn532_sim_tag_t f = { .brty = PN532_BAUDRATE_212K_FELICA,
+                          .uid = { 0x01, 0x2E, 0x3A, 0x4B, 0x5C, 0x6D, 0x7E, 0x8F }, .uid_length = 8 };
+    int idx[3] = { pn532_sim_add_tag(&a), pn532_sim_add_tag(&b), pn532_sim_add_tag(&f) };
+
+    nfc_sched_t sched;
+    nfc_sched_init(&sched, &sched_cfg);
+    bench_mark_t m;
+    mark(&m);
+    unsigned misses = 0;
+
+    for (unsigned n = 0; n < tag_count; n++) {
+        /* 70% type A, 15% type B, 15% FeliCa */
+        uint32_t r = rng_next() % 100;
+        int which = (r < 70) ? 0 : (r < 85) ? 1 : 2;
+        int64_t enter = host_clock_now_us() + (int64_t)(rng_next() % BENCH_ARRIVAL_MAX_MS) * 1000;
+        pn532_sim_set_tag_window(idx[which], enter, enter + BENCH_DWELL_MS * 1000LL);
+
+        for (;;) {
+            pn532_tag_info_t tag;
+            unsigned slot = nfc_sched_next(&sched);
+            pn532_err_t err = pn532_list_passive_target(&s_dev, sched_cfg.modes[slot],
+                                                        PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+            nfc_sched_report(&sched, slot, err == PN532_OK);
+            if (err == PN532_OK) {
+                s_latency_us[n] = (uint32_t)(host_clock_now_us() - enter);
+                pn532_release_target(&s_dev);
+                pn532_sim_set_tag_window(idx[which], 0, 0);
+                vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+                break;
+            }
+            if (host_clock_now_us() >= enter + BENCH_DWELL_MS * 1000LL) {
+                s_latency_us[n] = BENCH_DWELL_MS * 1000;
+                misses++;
+                break;
+            }
+            vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+        }
+    }
+
+    printf("Detection latency, %u arrivals (A 70%% / B 15%% / FeliCa 15%%), %d ms poll interval\n",
+           tag_count, PN532_POLL_INTERVAL_MS);
+    report("per detection", &m, tag_count);
+    printf("  %u missed (in the field %d ms without being listed)\n", misses, BENCH_DWELL_MS);
+
+    qsort(s_latency_us, tag_count, sizeof(s_latency_us[0]), cmp_u32);
+    printf("  p50 %u ms  p90 %u ms  p99 %u ms  max %u ms\n",
+           s_latency_us[tag_count * 50 / 100] / 1000, s_latency_us[tag_count * 90 / 100] / 1000,
+           s_latency_us[tag_count * 99 / 100] / 1000, s_latency_us[tag_count - 1] / 1000);
+
+    unsigned hist[BENCH_HIST_BUCKETS] = { 0 };
+    unsigned peak = 1;
+    for (unsigned n = 0; n < tag_count; n++) {
+        unsigned bucket = s_latency_us[n] / (BENCH_HIST_BUCKET_MS * 1000);
+        if (bucket >= BENCH_HIST_BUCKETS) {
+            bucket = BENCH_HIST_BUCKETS - 1;
+        }
+        if (++hist[bucket] > peak) {
+            peak = hist[bucket];
+        }
+    }
+    for (unsigned k = 0; k < BENCH_HIST_BUCKETS; k++) {
+        if (hist[k] == 0) {
+            continue;
+        }
+        if (k == BENCH_HIST_BUCKETS - 1) {
+            printf("  %4u+     ms %5u ", k * BENCH_HIST_BUCKET_MS, hist[k]);
+        } else {
+            printf("  %4u-%4u ms %5u ", k * BENCH_HIST_BUCKET_MS, (k + 1) * BENCH_HIST_BUCKET_MS, hist[k]);
+        }
+        for (unsigned w = 0; w < hist[k] * BENCH_HIST_WIDTH / peak; w++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+    for (unsigned k = 0; k < sched_cfg.mode_count; k++) {
+        nfc_sched_mode_stats_t st;
+        nfc_sched_get_stats(&sched, k, &st);
+        printf("  BrTy %u: %u polls, %u hits, %u forced, rate %u/%d\n", sched_cfg.modes[k],
+               (unsigned)st.polls, (unsigned)st.hits, (unsigned)st.forced, st.rate, NFC_SCHED_RATE_ONE);
+    }
+}
+
+/* An NTAG216 on the reader from now on, memory filled with a known pattern */
+static int add_ntag(void)
+{
+    pn532_sim_tag_t t = { .brty = PN532_BAUDRATE_106K_ISO14443A,
+                          .uid = { 0x04, 0xA1, 0xB2, 0xC3, 0xD4, 0xE5, 0xF6 }, .uid_length = 7,
+                          .sak = 0x00, .atqa = { 0x00, 0x44 },
+                          .mem = s_ntag_mem, .mem_len = sizeof(s_ntag_mem), .leave_us = INT64_MAX };
+    for (size_t k = 0; k < sizeof(s_ntag_mem); k++) {
+        s_ntag_mem[k] = (uint8_t)(k * 7);
+    }
+    return pn532_sim_add_tag(&t);
+}
+
+static void bench_ntag(void)
+{
+    static uint8_t buf[BENCH_NTAG_USER_LEN];
+    static uint8_t pattern[BENCH_NTAG_USER_LEN];
+    for (size_t k = 0; k < sizeof(pattern); k++) {
+        pattern[k] = (uint8_t)rng_next();
+    }
+    int idx = add_ntag();
+    pn532_tag_info_t tag;
+    bench_mark_t m;
+
+    printf("NTAG216, %d user bytes\n", BENCH_NTAG_USER_LEN);
+    check(pn532_read_passive_target(&s_dev, PN532_TAG_DETECT_TIMEOUT_MS, &tag) == PN532_OK, "NTAG select");
+
+    mark(&m);
+    uint8_t last = BENCH_NTAG_FIRST_PAGE + BENCH_NTAG_USER_PAGES - 1;
+    pn532_err_t err = pn532_ntag_fast_read(&s_dev, tag.tg, BENCH_NTAG_FIRST_PAGE, last, buf, sizeof(buf));
+    report("FAST_READ", &m, 1);
+    check(err == PN532_OK &&
+          memcmp(buf, s_ntag_mem + BENCH_NTAG_FIRST_PAGE * PN532_NTAG_PAGE_SIZE, sizeof(buf)) == 0,
+          "FAST_READ data");
+
+    pn532_ntag_write_result_t res;
+    mark(&m);
+    err = pn532_ntag_write_pages(&s_dev, tag.tg, BENCH_NTAG_FIRST_PAGE, pattern, BENCH_NTAG_USER_PAGES,
+                                 true, &res);
+    report("WRITE + verify", &m, 1);
+    printf("  %u pages, write %u us, verify %u us, %u pages/s\n",
+           res.pages, (unsigned)res.write_us, (unsigned)res.verify_us, (unsigned)res.pages_per_s);
+    check(err == PN532_OK &&
+          memcmp(pattern, s_ntag_mem + BENCH_NTAG_FIRST_PAGE * PN532_NTAG_PAGE_SIZE, sizeof(pattern)) == 0,
+          "written data");
+
+    pn532_release_target(&s_dev);
+    pn532_sim_set_tag_window(idx, 0, 0);
+}
+
+/* Sector 0 opens with the MAD key, the rest with the NFC Forum key; key B is factory */
+static void classic_set_keys(void)
+{
+    static const uint8_t mad_key[] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 };
+    static const uint8_t nfc_key[] = { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 };
+    for (unsigned s = 0; s < BENCH_CLASSIC_SECTORS; s++) {
+        uint8_t *trailer = s_classic_mem + (s * 4 + 3) * PN532_MIFARE_BLOCK_SIZE;
+        memcpy(trailer, s == 0 ? mad_key : nfc_key, PN532_MIFARE_KEY_LEN);
+        trailer[6] = 0xFF;
+        trailer[7] = 0x07;
+        trailer[8] = 0x80;
+        trailer[9] = 0x69;
+        memset(trailer + 10, 0xFF, PN532_MIFARE_KEY_LEN);
+    }
+}
+
+static void bench_classic(void)
+{
+    static const pn532_mifare_key_t keys[] = {
+        { PN532_MIFARE_CMD_AUTH_A, { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } },
+        { PN532_MIFARE_CMD_AUTH_A, { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 } },
+        { PN532_MIFARE_CMD_AUTH_A, { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 } },
+    };
+    pn532_sim_tag_t t = { .brty = PN532_BAUDRATE_106K_ISO14443A, .uid = { 0xDE, 0xAD, 0xBE, 0xEF },
+                          .uid_length = 4, .sak = 0x08, .atqa = { 0x00, 0x04 },
+                          .mem = s_classic_mem, .mem_len = sizeof(s_classic_mem), .leave_us = INT64_MAX };
+    for (size_t k = 0; k < sizeof(s_classic_mem); k++) {
+        s_classic_mem[k] = (uint8_t)(k * 13);
+    }
+    classic_set_keys();
+    int idx = pn532_sim_add_tag(&t);
+    pn532_tag_info_t tag;
+    uint8_t buf[4 * PN532_MIFARE_BLOCK_SIZE];
+    size_t len = 0;
+    bench_mark_t m;
+
+    static const char *const passes[] = { "cold cache", "cached keys" };
+    printf("MIFARE Classic 1K, sector 0 (MAD key) then 1 (D3F7), key list FF / A0 / D3F7\n");
+    check(pn532_read_passive_target(&s_dev, PN532_TAG_DETECT_TIMEOUT_MS, &tag) == PN532_OK, "Classic select");
+    pn532_mifare_key_cache_clear(&s_dev);
+
+    for (int pass = 0; pass < 2; pass++) {
+        pn532_sim_stats_t before, after;
+        pn532_sim_get_stats(&before);
+        for (uint8_t sector = 0; sector < 2; sector++) {
+            char what[40];
+            snprintf(what, sizeof(what), "sector %u, %s", sector, passes[pass]);
+            mark(&m);
+            pn532_err_t err = pn532_mifare_read_sector(&s_dev, &tag, sector, keys,
+                                                       sizeof(keys) / sizeof(keys[0]),
+                                                       buf, sizeof(buf), &len);
+            report(what, &m, 1);
+            /* Key A of the trailer reads back as zeros */
+            check(err == PN532_OK && len == sizeof(buf) &&
+                  memcmp(buf, s_classic_mem + sector * 4 * PN532_MIFARE_BLOCK_SIZE,
+                         3 * PN532_MIFARE_BLOCK_SIZE) == 0, "sector data");
+        }
+        pn532_sim_get_stats(&after);
+        printf("  %s: %u re-selects\n", passes[pass], (unsigned)(after.activations - before.activations));
+        if (pass == 1) {
+            check(after.activations == before.activations, "no re-select with cached keys");
+        }
+    }
+
+    pn532_release_target(&s_dev);
+    pn532_sim_set_tag_window(idx, 0, 0);
+}
+
+static bool bench_apply_rf_config(void)
+{
+    return pn532_set_max_retries(&s_dev, PN532_RFCFG_RETRY_FOREVER, 0x01,
+                                 BENCH_PASSIVE_RETRIES) == PN532_OK &&
+           pn532_set_rf_timings(&s_dev, 0x0B, BENCH_NONDEP_TIMEOUT) == PN532_OK;
+}
+
+/*
+ * The polling_task() error path (doc §15.4) on an empty field. The fault
+ * starts just before a poll; time to recovery runs from that poll to the
+ * first one answered again. The first error is
+ * retried at once, later ones recover; a failed recovery backs off for a
+ * poll interval and the configuration is restored once the PN532 answers.
+ */
+static void bench_recovery_case(const char *what, pn532_sim_fault_t fault)
+{
+    pn532_tag_info_t tag;
+    uint64_t total_us = 0;
+    uint32_t max_us = 0;
+    unsigned within = 0;
+    pn532_recovery_stats_t rs0, rs;
+    pn532_get_recovery_stats(&s_dev, &rs0);
+
+    printf("%s x%d\n", what, BENCH_RECOVERY_ROUNDS);
+    for (int i = 0; i < BENCH_RECOVERY_ROUNDS; i++) {
+        vTaskDelay(pdMS_TO_TICKS(rng_next() % PN532_POLL_INTERVAL_MS));
+        pn532_sim_inject_fault(fault, (int64_t)(1 + rng_next() % BENCH_BROWNOUT_MAX_MS) * 1000);
+
+        int64_t start = 0;
+        unsigned errors = 0;
+        bool stale = false;
+        pn532_err_t err;
+        for (int polls = 0; polls < BENCH_OUTAGE_POLLS_MAX; polls++) {
+            int64_t t = host_clock_now_us();
+            err = pn532_list_passive_target(&s_dev, PN532_BAUDRATE_106K_ISO14443A,
+                                            PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+            if (err == PN532_OK || err == PN532_ERR_NOT_FOUND || err == PN532_ERR_TIMEOUT) {
+                break;
+            }
+            if (errors++ == 0) {
+                start = t;
+            }
+            if (errors < BENCH_RECOVER_AFTER) {
+                continue;
+            }
+            stale = pn532_recover(&s_dev) != PN532_OK;
+            if (stale) {
+                vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+            } else {
+                check(bench_apply_rf_config(), "RF configuration after recovery");
+            }
+        }
+        uint32_t us = (uint32_t)(host_clock_now_us() - start);
+        if (stale) {
+            check(pn532_sam_config(&s_dev) == PN532_OK && bench_apply_rf_config(),
+                  "configuration after the PN532 came back");
+        }
+        check(errors > 0, "fault seen");
+        check(err == PN532_ERR_NOT_FOUND || err == PN532_ERR_TIMEOUT, "poll after recovery");
+        total_us += us;
+        if (us > max_us) {
+            max_us = us;
+        }
+        within += us <= PN532_POLL_INTERVAL_MS * 1000;
+        /* The next empty poll must be fast again: RFConfiguration is back */
+        err = pn532_list_passive_target(&s_dev, PN532_BAUDRATE_106K_ISO14443A,
+                                        PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+        check(err == PN532_ERR_NOT_FOUND, "empty poll after recovery");
+    }
+    pn532_get_recovery_stats(&s_dev, &rs);
+    uint32_t runs = rs.attempts - rs0.attempts;
+    printf("  time to recovery mean %.1f ms, max %.1f ms, %u/%d within one poll interval\n",
+           (double)total_us / BENCH_RECOVERY_ROUNDS / 1000.0, max_us / 1000.0, within,
+           BENCH_RECOVERY_ROUNDS);
+    printf("  pn532_recover %u runs, %u failed, mean %.1f ms\n", (unsigned)runs,
+           (unsigned)(rs.failures - rs0.failures),
+           runs ? (double)(rs.total_us - rs0.total_us) / runs / 1000.0 : 0.0);
+}
+
+static void bench_recovery(void)
+{
+    bench_recovery_case("Stuck bus", PN532_SIM_FAULT_BUS_STUCK);
+    bench_recovery_case("Brown-out 1..100 ms", PN532_SIM_FAULT_BROWNOUT);
+}
+
+/*
+ * Empty-field polling of 106A under a cadence: latency from the tag entering
+ * to the list returning, and the share of time the reader was busy. Every
+ * detection counts as activity, like a tag leaving in polling_task().
+ */
+static void bench_cadence_run(const char *what, const nfc_cadence_config_t *cfg, int idx,
+                              uint32_t seed)
+{
+    nfc_cadence_t cad;
+    uint32_t lat_ms[BENCH_CADENCE_ARRIVALS];
+    pn532_tag_info_t tag;
+    s_rng = seed;
+    nfc_cadence_init(&cad, cfg, host_clock_now_us());
+    int64_t run_start = host_clock_now_us();
+
+    for (unsigned n = 0; n < BENCH_CADENCE_ARRIVALS; n++) {
+        uint32_t gap_ms = rng_next() % BENCH_BURST_GAP_MAX_MS;
+        if (rng_next() % 100 >= BENCH_BURST_PCT) {
+            gap_ms = BENCH_IDLE_GAP_MIN_MS + rng_next() % (BENCH_IDLE_GAP_MAX_MS - BENCH_IDLE_GAP_MIN_MS);
+        }
+        int64_t enter = host_clock_now_us() + (int64_t)gap_ms * 1000;
+        pn532_sim_set_tag_window(idx, enter, INT64_MAX);
+        for (;;) {
+            int64_t busy_start = host_clock_now_us();
+            pn532_err_t err = pn532_list_passive_target(&s_dev, PN532_BAUDRATE_106K_ISO14443A,
+                                                        PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+            if (err == PN532_OK) {
+                lat_ms[n] = (uint32_t)((host_clock_now_us() - enter) / 1000);
+                pn532_release_target(&s_dev);
+                pn532_sim_set_tag_window(idx, 0, 0);
+                nfc_cadence_activity(&cad, host_clock_now_us());
+                nfc_cadence_account(&cad, (uint32_t)(host_clock_now_us() - busy_start), 0);
+                break;
+            }
+            check(err == PN532_ERR_NOT_FOUND, "cadence poll");
+            uint32_t busy = (uint32_t)(host_clock_now_us() - busy_start);
+            int64_t idle_start = host_clock_now_us();
+            vTaskDelay(pdMS_TO_TICKS(nfc_cadence_interval_ms(&cad, idle_start)));
+            nfc_cadence_account(&cad, busy, (uint32_t)(host_clock_now_us() - idle_start));
+        }
+    }
+
+    nfc_cadence_stats_t st;
+    nfc_cadence_get_stats(&cad, &st);
+    unsigned duty = nfc_cadence_duty_permille(&cad);
+    double minutes = (double)(host_clock_now_us() - run_start) / 60e6;
+    qsort(lat_ms, BENCH_CADENCE_ARRIVALS, sizeof(lat_ms[0]), cmp_u32);
+    printf("  %-24s p50 %4u ms  p90 %4u ms  max %4u ms  %6.0f polls/min  duty %u.%u%%\n", what,
+           lat_ms[BENCH_CADENCE_ARRIVALS * 50 / 100], lat_ms[BENCH_CADENCE_ARRIVALS * 90 / 100],
+           lat_ms[BENCH_CADENCE_ARRIVALS - 1], st.polls / minutes, duty / 10, duty % 10);
+}
+
+static void bench_cadence(void)
+{
+    static const nfc_cadence_config_t fixed = {
+        .fast_ms = PN532_POLL_INTERVAL_MS, .slow_ms = PN532_POLL_INTERVAL_MS,
+        .decay = NFC_CADENCE_DECAY_STEP,
+    };
+    /* NFC_CADENCE_* defaults in main.c */
+    static const nfc_cadence_config_t adaptive = {
+        .fast_ms = 30, .slow_ms = 500, .hold_ms = 5000, .decay_ms = 5000,
+        .decay = NFC_CADENCE_DECAY_EXPONENTIAL,
+    };
+    static const nfc_cadence_config_t linear = {
+        .fast_ms = 30, .slow_ms = 500, .hold_ms = 5000, .decay_ms = 20000,
+        .decay = NFC_CADENCE_DECAY_LINEAR,
+    };
+    pn532_sim_tag_t a = { .brty = PN532_BAUDRATE_106K_ISO14443A,
+                          .uid = { 0x04, 0xCA, 0xDE, 0x0C, 0xE0, 0x00, 0x01 }, .uid_length = 7,
+                          .sak = 0x00, .atqa = { 0x00, 0x44 } };
+    int idx = pn532_sim_add_tag(&a);
+    uint32_t seed = rng_next();
+
+    printf("Poll cadence, %d taps (%d%% within %d s of the last, else %d..%d s idle)\n",
+           BENCH_CADENCE_ARRIVALS, BENCH_BURST_PCT, BENCH_BURST_GAP_MAX_MS / 1000,
+           BENCH_IDLE_GAP_MIN_MS / 1000, BENCH_IDLE_GAP_MAX_MS / 1000);
+    bench_cadence_run("fixed 250 ms", &fixed, idx, seed);
+    bench_cadence_run("30..500 ms, exponential", &adaptive, idx, seed);
+    bench_cadence_run("30..500 ms, linear", &linear, idx, seed);
+}
+
+/* pn532_get_stats() over the whole run: where each command's time went (doc §15.3) */
+/*
+ * The same commands over each PN532 interface (doc §7.5, §7.6), HSU at the
+ * power-on rate and raised with SetSerialBaudRate. Starts the simulator over.
+ */
+static void bench_transport(const char *name, const pn532_sim_config_t *cfg, pn532_transport_t transport,
+                            uint32_t baud)
+{
+    static uint8_t buf[BENCH_NTAG_USER_LEN];
+    pn532_firmware_version_t fw;
+    pn532_tag_info_t tag;
+    bench_mark_t m;
+    char what[32];
+
+    pn532_sim_init(cfg);
+    if (!bench_init(transport) || (baud && pn532_set_serial_baud_rate(&s_dev, baud) != PN532_OK)) {
+        check(false, name);
+        return;
+    }
+    add_ntag();
+
+    mark(&m);
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        check(pn532_get_firmware_version(&s_dev, &fw) == PN532_OK && fw.ic == 0x32, "GetFirmwareVersion");
+    }
+    snprintf(what, sizeof(what), "%s round trip", name);
+    report(what, &m, BENCH_ROUNDS);
+
+    /* HSU steps only read what the UART has buffered, so none waits on the wire */
+    unsigned calls = 0;
+    bool nacked = false;
+    int64_t max_step_us = async_rounds(BENCH_ROUNDS, &calls, &nacked);
+    snprintf(what, sizeof(what), "%s async", name);
+    printf("  %-26s %9.1f calls/command, longest %lld us\n", what, (double)calls / BENCH_ROUNDS,
+           (long long)max_step_us);
+    if (transport == PN532_TRANSPORT_HSU) {
+        check(max_step_us == 0, "HSU pn532_process() step without waiting on the UART");
+    }
+
+    check(pn532_read_passive_target(&s_dev, PN532_TAG_DETECT_TIMEOUT_MS, &tag) == PN532_OK, "NTAG select");
+    mark(&m);
+    uint8_t last = BENCH_NTAG_FIRST_PAGE + BENCH_NTAG_USER_PAGES - 1;
+    pn532_err_t err = pn532_ntag_fast_read(&s_dev, tag.tg, BENCH_NTAG_FIRST_PAGE, last, buf, sizeof(buf));
+    int64_t us = host_clock_now_us() - m.t_us;
+    snprintf(what, sizeof(what), "%s FAST_READ", name);
+    report(what, &m, 1);
+    snprintf(what, sizeof(what), "%s throughput", name);
+    printf("  %-26s %9.1f kB/s\n", what, (double)sizeof(buf) * 1000 / (double)us);
+    check(err == PN532_OK &&
+          memcmp(buf, s_ntag_mem + BENCH_NTAG_FIRST_PAGE * PN532_NTAG_PAGE_SIZE, sizeof(buf)) == 0,
+          "FAST_READ data");
+    pn532_release_target(&s_dev);
+}
+
+static void bench_transports(const pn532_sim_config_t *cfg)
+{
+    char name[16];
+    printf("Transports, GetFirmwareVersion x%d and FAST_READ of %d bytes\n", BENCH_ROUNDS,
+           BENCH_NTAG_USER_LEN);
+    snprintf(name, sizeof(name), "I2C %u us/B", (unsigned)cfg->bus_us_per_byte);
+    bench_transport(name, cfg, PN532_TRANSPORT_I2C, 0);
+    snprintf(name, sizeof(name), "SPI %u kHz", (unsigned)(cfg->spi_clock_hz / 1000));
+    bench_transport(name, cfg, PN532_TRANSPORT_SPI, 0);
+    bench_transport("HSU 115200", cfg, PN532_TRANSPORT_HSU, 0);
+    bench_transport("HSU 460800", cfg, PN532_TRANSPORT_HSU, 460800);
+    bench_transport("HSU 921600", cfg, PN532_TRANSPORT_HSU, 921600);
+}
+
+static void bench_driver_stats(void)
+{
+    static pn532_stats_t st;
+    if (pn532_get_stats(&s_dev, &st) != PN532_OK) {
+        printf("Driver stats: built with PN532_STATS_ENABLE 0\n");
+        return;
+    }
+    printf("Driver stats, mean us per phase\n");
+    printf("  cmd  count   err    write      ack     wait     read      max\n");
+    for (unsigned k = 0; k < PN532_STATS_COMMANDS && st.commands[k].count; k++) {
+        const pn532_command_stats_t *c = &st.commands[k];
+        printf("  %02X %6u %5u", c->command, (unsigned)c->count, (unsigned)c->errors);
+        for (unsigned p = 0; p < PN532_PHASE_COUNT; p++) {
+            printf(" %8u", (unsigned)(c->phase_total_us[p] / c->count));
+        }
+        printf(" %8u\n", (unsigned)c->max_us);
+    }
+    printf("  results:");
+    for (unsigned e = 0; e < PN532_ERR_COUNT; e++) {
+        if (st.results[e]) {
+            printf(" %u=%u", e, (unsigned)st.results[e]);
+        }
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned seed = 1;
+    unsigned tag_count = 200;
+    pn532_sim_config_t cfg;
+    pn532_sim_config_default(&cfg);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:b:")) != -1) {
+        switch (opt) {
+            case 's':
+                seed = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                tag_count = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                cfg.bus_us_per_byte = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s seed] [-n tags] [-b bus_us_per_byte]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (tag_count < 1 || tag_count > BENCH_MAX_TAGS) {
+        fprintf(stderr, "-n must be 1..%d\n", BENCH_MAX_TAGS);
+        return 2;
+    }
+    s_rng = seed ? seed : 1;
+
+    pn532_sim_init(&cfg);
+    if (!bench_init(PN532_TRANSPORT_I2C)) {
+        fprintf(stderr, "PN532 init against the simulator failed\n");
+        return 1;
+    }
+    printf("pn532_bench: seed %u, bus %u us/byte, virtual time\n\n", seed, (unsigned)cfg.bus_us_per_byte);
+    pn532_sim_reset_stats();
+    pn532_reset_stats(&s_dev);
+
+    bench_firmware_version();
+    bench_async();
+    bench_empty_poll();
+    bench_detection(tag_count);
+    bench_ntag();
+    bench_classic();
+    bench_cadence();
+    bench_driver_stats();
+    bench_recovery();
+    bench_transports(&cfg);
+
+    printf("\n%s\n", s_failures ? "FAILED" : "OK");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+/**
+ * Provisioning station against the simulated PN532 (TECHNICAL_DOCUMENTATION.md
+ * §10.7, §19). Streams one NDEF message onto a batch of blank NTAGs presented
+ * one after another, with the same loop as nfc_provision() in main.c: wrap
+ * the message in a TLV, check each tag's CC, write from page 4 with
+ * pn532_ntag_write_pages() and verify. Each written image is also compared
+ * against tag memory and parsed back with ndef_find_message(). Times are
+ * virtual. Exit status 1 if any tag is missed or fails.
+ *
+ * Usage: pn532_provision [-n tags] [-t 213|215|216] [-b bus_us_per_byte] [-d dwell_ms] [-V] [file]
+ * file is the raw NDEF message (stdin if absent or "-").
+ */
+
+#include "host_port.h"
+#include "ndef.h"
+#include "pn532.h"
+#include "pn532_sim.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Same RF settings as nfc_init() in main.c */
+#define PROV_PASSIVE_RETRIES    0x01
+#define PROV_NONDEP_TIMEOUT     0x09
+
+#define PROV_MAX_TAGS           10000
+#define PROV_FIRST_PAGE         4
+#define PROV_MEM_MAX            (231 * PN532_NTAG_PAGE_SIZE)   /* NTAG216 */
+#define PROV_GAP_MS             500    /* Hand off one tag, pick up the next */
+
+typedef struct {
+    unsigned model;                  /* 213, 215 or 216 */
+    unsigned pages;                  /* Whole memory, config pages included */
+    uint8_t cc_size;                 /* CC[2]: data area / 8 */
+} prov_ntag_t;
+
+static const prov_ntag_t PROV_NTAGS[] = {
+    { 213, 45, 0x12 },
+    { 215, 135, 0x3E },
+    { 216, 231, 0x6D },
+};
+
+static pn532_dev_t s_dev;
+static uint8_t s_msg[PROV_MEM_MAX];
+static uint8_t s_image[PROV_MEM_MAX];
+static uint8_t s_mem[PROV_MEM_MAX];
+
+static bool prov_init(void)
+{
+    pn532_config_t cfg = PN532_CONFIG_DEFAULT();
+    cfg.transport = PN532_TRANSPORT_I2C;
+    cfg.irq_gpio = -1;
+    cfg.rst_gpio = -1;
+    if (pn532_init(&s_dev, &cfg) != PN532_OK) {
+        return false;
+    }
+    pn532_wakeup(&s_dev);
+    return pn532_sam_config(&s_dev) == PN532_OK &&
+           pn532_set_max_retries(&s_dev, PN532_RFCFG_RETRY_FOREVER, 0x01,
+                                 PROV_PASSIVE_RETRIES) == PN532_OK &&
+           pn532_set_rf_timings(&s_dev, 0x0B, PROV_NONDEP_TIMEOUT) == PN532_OK;
+}
+
+/* A factory-fresh NTAG: UID and BCCs in pages 0-2, CC in page 3, empty NDEF TLV from page 4 */
+static void blank_tag(pn532_sim_tag_t *t, const prov_ntag_t *model, unsigned n)
+{
+    uint8_t uid[7] = { 0x04, 0x50, 0x52, (uint8_t)(n >> 16), (uint8_t)(n >> 8), (uint8_t)n, 0x80 };
+    memset(s_mem, 0, sizeof(s_mem));
+    memcpy(s_mem, uid, 3);
+    s_mem[3] = 0x88 ^ uid[0] ^ uid[1] ^ uid[2];
+    memcpy(s_mem + 4, uid + 3, 4);
+    s_mem[8] = uid[3] ^ uid[4] ^ uid[5] ^ uid[6];
+    static const uint8_t empty_ndef[] = { 0x03, 0x00, 0xFE };
+    uint8_t cc[NDEF_CC_LEN] = { 0xE1, 0x10, model->cc_size, 0x00 };
+    memcpy(s_mem + 3 * PN532_NTAG_PAGE_SIZE, cc, sizeof(cc));
+    memcpy(s_mem + PROV_FIRST_PAGE * PN532_NTAG_PAGE_SIZE, empty_ndef, sizeof(empty_ndef));
+
+    *t = (pn532_sim_tag_t){ .brty = PN532_BAUDRATE_106K_ISO14443A, .uid_length = sizeof(uid),
+                            .sak = 0x00, .atqa = { 0x00, 0x44 },
+                            .mem = s_mem, .mem_len = model->pages * PN532_NTAG_PAGE_SIZE };
+    memcpy(t->uid, uid, sizeof(uid));
+}
+
+/* Whole file or stdin into s_msg; 0 if empty, unreadable or larger than any tag */
+static size_t read_message(const char *path)
+{
+    FILE *f = (path && strcmp(path, "-") != 0) ? fopen(path, "rb") : stdin;
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    size_t n = fread(s_msg, 1, sizeof(s_msg), f);
+    bool more = fgetc(f) != EOF;
+    if (f != stdin) {
+        fclose(f);
+    }
+    return more ? 0 : n;
+}
+
+/*
+ * Write and check the selected tag, printing one PROV line like the
+ * firmware. True if the image is on the tag and parses back to the message.
+ */
+static bool provision_tag(const pn532_tag_info_t *tag, unsigned pages, size_t msg_len, bool verify,
+                          pn532_ntag_write_result_t *res)
+{
+    uint8_t cc_page[PN532_NTAG_READ_LEN];
+    ndef_cc_t cc;
+    bool ok = false;
+
+    printf("PROV ");
+    for (int i = 0; i < tag->uid_length; i++) {
+        printf("%02X", tag->uid[i]);
+    }
+    *res = (pn532_ntag_write_result_t){ 0 };
+    if (tag->type != PN532_TAG_NTAG && tag->type != PN532_TAG_MIFARE_ULTRALIGHT) {
+        printf(": not a Type 2 tag\n");
+    } else if (pn532_ntag_read(&s_dev, tag->tg, 3, cc_page) != PN532_OK ||
+               ndef_parse_cc(cc_page, &cc) != NDEF_OK) {
+        printf(": no NDEF capability container\n");
+    } else if ((cc.access & 0x0F) != 0x00 || cc.data_area_size < pages * PN532_NTAG_PAGE_SIZE) {
+        printf(": read-only or too small (%u bytes)\n", (unsigned)cc.data_area_size);
+    } else {
+        pn532_err_t err = pn532_ntag_write_pages(&s_dev, tag->tg, PROV_FIRST_PAGE, s_image, pages,
+                                                 verify, res);
+        const uint8_t *data = s_mem + PROV_FIRST_PAGE * PN532_NTAG_PAGE_SIZE;
+        ndef_view_t msg;
+        size_t needed;
+        ok = err == PN532_OK && memcmp(data, s_image, pages * PN532_NTAG_PAGE_SIZE) == 0 &&
+             ndef_find_message(data, cc.data_area_size, &msg, &needed) == NDEF_OK &&
+             msg.len == msg_len && memcmp(msg.ptr, s_msg, msg_len) == 0;
+        printf(": %u/%u pages, write %lu us, verify %lu us, %lu pages/s %s\n",
+               res->pages, pages, (unsigned long)res->write_us, (unsigned long)res->verify_us,
+               (unsigned long)res->pages_per_s, ok ? "OK" : "FAIL");
+    }
+    pn532_release_target(&s_dev);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned tag_count = 10;
+    unsigned model_no = 215;
+    unsigned dwell_ms = 3000;
+    bool verify = true;
+    pn532_sim_config_t cfg;
+    pn532_sim_config_default(&cfg);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:t:b:d:V")) != -1) {
+        switch (opt) {
+            case 'n':
+                tag_count = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                model_no = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                cfg.bus_us_per_byte = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                dwell_ms = (unsigned)strtoul(optarg, NULL, 0);
+                break;
+            case 'V':
+                verify = false;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n tags] [-t 213|215|216] [-b bus_us_per_byte] [-d dwell_ms] "
+                        "[-V] [file]\n", argv[0]);
+                return 2;
+        }
+    }
+    const prov_ntag_t *model = NULL;
+    for (size_t k = 0; k < sizeof(PROV_NTAGS) / sizeof(PROV_NTAGS[0]); k++) {
+        if (PROV_NTAGS[k].model == model_no) {
+            model = &PROV_NTAGS[k];
+        }
+    }
+    if (!model || tag_count < 1 || tag_count > PROV_MAX_TAGS) {
+        fprintf(stderr, "-t must be 213, 215 or 216 and -n 1..%d\n", PROV_MAX_TAGS);
+        return 2;
+    }
+
+    size_t msg_len = read_message(optind < argc ? argv[optind] : NULL);
+    size_t tlv_len = 0;
+    if (msg_len == 0 || ndef_build_tlv(s_msg, msg_len, s_image, sizeof(s_image), &tlv_len) != NDEF_OK) {
+        fprintf(stderr, "NDEF message empty or larger than an NTAG216\n");
+        return 2;
+    }
+    unsigned pages = (unsigned)((tlv_len + PN532_NTAG_PAGE_SIZE - 1) / PN532_NTAG_PAGE_SIZE);
+
+    pn532_sim_init(&cfg);
+    if (!prov_init()) {
+        fprintf(stderr, "PN532 init against the simulator failed\n");
+        return 1;
+    }
+    printf("PROV: image %u bytes, %u pages, %u x NTAG%u, at most %u ms on the reader, verify %s\n",
+           (unsigned)msg_len, pages, tag_count, model->model, dwell_ms, verify ? "on" : "off");
+
+    /*
+     * One tag in the field at a time. Each enters PROV_GAP_MS after the last
+     * one left and is taken off once written, or after dwell_ms if it never is.
+     */
+    pn532_sim_tag_t t;
+    blank_tag(&t, model, 0);
+    int idx = pn532_sim_add_tag(&t);
+    unsigned ok_count = 0;
+    uint64_t pages_total = 0;
+    uint64_t rf_us_total = 0;
+    int64_t start_us = host_clock_now_us();
+
+    for (unsigned n = 0; n < tag_count; n++) {
+        blank_tag(&t, model, n);
+        t.enter_us = host_clock_now_us() + PROV_GAP_MS * 1000LL;
+        t.leave_us = t.enter_us + dwell_ms * 1000LL;
+        pn532_sim_replace_tag(idx, &t);
+
+        /* The nfc_provision() loop: poll until the tag answers or has left */
+        bool done = false;
+        while (!done && host_clock_now_us() < t.leave_us) {
+            pn532_tag_info_t tag;
+            if (pn532_read_passive_target(&s_dev, PN532_TAG_DETECT_TIMEOUT_MS, &tag) != PN532_OK) {
+                vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+                continue;
+            }
+            pn532_ntag_write_result_t res;
+            if (provision_tag(&tag, pages, msg_len, verify, &res)) {
+                ok_count++;
+                pages_total += res.pages;
+                rf_us_total += res.write_us + res.verify_us;
+            }
+            done = true;
+        }
+        if (!done) {
+            printf("PROV tag %u: left the reader before it was detected\n", n);
+        }
+        pn532_sim_set_tag_window(idx, 0, 0);   /* The operator takes it off */
+    }
+
+    double minutes = (double)(host_clock_now_us() - start_us) / 60e6;
+    printf("PROV: %u/%u tags OK, %.0f tags/min, %lu pages/s while writing\n", ok_count, tag_count,
+           tag_count / minutes, rf_us_total ? (unsigned long)(pages_total * 1000000 / rf_us_total) : 0UL);
+    return ok_count == tag_count ? 0 : 1;
+}
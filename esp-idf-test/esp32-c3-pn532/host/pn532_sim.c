@@ -0,0 +1,890 @@
+/**
+ * Simulated PN532. See TECHNICAL_DOCUMENTATION.md §19.
+ *
+ * The host sees what it would on the bus. On I2C and SPI: a status byte of
+ * 0x00 until the next frame is due on the virtual clock, then 0x01 and the
+ * frame. Reading a frame consumes it; a NACK from the host re-sends the last
+ * response (doc §8.3). On HSU the PN532 transmits each frame when it is due
+ * and the bytes arrive one character time apart. Bus, ACK, processing and RF
+ * times all advance the clock. While a fault is active every transaction
+ * fails after its address byte.
+ */
+
+#include "pn532_sim.h"
+#include "pn532_transport.h"
+#include "host_port.h"
+#include <string.h>
+
+#define SIM_STATUS_OK          0x00
+#define SIM_STATUS_TIMEOUT     0x01  /* Target did not answer */
+#define SIM_STATUS_AUTH_ERROR  0x14  /* MIFARE authentication error */
+#define SIM_RF_TIMEOUT_US      25600 /* RFConfiguration item 2 as main.c sets it */
+#define SIM_CLASSIC_KEY_B_OFF  10
+#define SIM_RECOVER_US         200   /* 9 clocks, STOP and driver re-install */
+#define SIM_HSU_BITS_PER_BYTE  10    /* 8N1 */
+#define SIM_HSU_FIFO_FULL      120   /* UART_DATA after this many bytes (ESP-IDF default) ... */
+#define SIM_HSU_RX_TOUT        2     /* ... or this many idle characters, as pn532_hsu.c sets */
+
+static const uint8_t ACK_FRAME[] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
+static const uint8_t NACK_FRAME[] = { 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00 };
+/* Application-level error frame, sent for commands the simulator lacks (doc §4) */
+static const uint8_t ERROR_FRAME[] = { 0x00, 0x00, 0xFF, 0x01, 0xFF, 0x7F, 0x81, 0x00 };
+/* SetSerialBaudRate BR codes (doc §6.8) */
+static const uint32_t SIM_HSU_BAUD[] = { 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 1288000 };
+/* Minimal ATS for SAK 0x20 targets: TL, T0, TA, TB, TC */
+static const uint8_t SIM_ATS[] = { 0x05, 0x75, 0x77, 0x81, 0x02 };
+
+static pn532_sim_config_t s_cfg;
+static pn532_sim_stats_t s_stats;
+static pn532_sim_tag_t s_tags[PN532_SIM_MAX_TAGS];
+static unsigned s_tag_count;
+
+/* Output side: ACK first, then the response; s_resp survives reads for NACK */
+static bool s_ack_pending;
+static int64_t s_ack_ready_us;
+static bool s_resp_pending;
+static bool s_resp_valid;
+static int64_t s_resp_ready_us;
+static uint8_t s_resp[PN532_FRAME_MAX_LEN];
+static size_t s_resp_len;
+
+/* Interface the driver attached to; set by the transport's init op */
+static pn532_transport_t s_bus;
+
+/* HSU: PN532 and host rates, and the frame being received (s_rx NULL = line idle) */
+static uint32_t s_hsu_baud;
+static uint32_t s_hsu_baud_next;     /* SetSerialBaudRate; taken on the host's ACK */
+static uint32_t s_host_baud;
+static const uint8_t *s_rx;
+static size_t s_rx_len;
+static size_t s_rx_pos;
+static int64_t s_rx_start_us;
+
+/* RF side */
+static int s_active = -1;            /* Tag activated as Tg 1 */
+static int s_auth_sector = -1;       /* Classic sector authenticated on s_active */
+static uint8_t s_passive_retries = PN532_RFCFG_RETRY_FOREVER;
+
+/* Injected fault; a brown-out ends at s_fault_until_us */
+static pn532_sim_fault_t s_fault;
+static int64_t s_fault_until_us;
+
+void pn532_sim_config_default(pn532_sim_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->bus_us_per_byte = 90;
+    cfg->spi_clock_hz = PN532_SPI_CLOCK_HZ;
+    cfg->spi_txn_us = 10;
+    cfg->ack_us = 300;
+    cfg->default_cmd_us = 500;
+    cfg->cmd_us[PN532_CMD_IN_LIST_PASSIVE_TARGET] = 2500;
+    cfg->cmd_us[PN532_CMD_IN_DATA_EXCHANGE] = 800;
+    cfg->activation_us = 1000;
+    cfg->rf_us_per_byte = 90;
+    cfg->write_us = 4100;
+}
+
+void pn532_sim_init(const pn532_sim_config_t *cfg)
+{
+    if (cfg) {
+        s_cfg = *cfg;
+    } else {
+        pn532_sim_config_default(&s_cfg);
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+    memset(s_tags, 0, sizeof(s_tags));
+    s_tag_count = 0;
+    s_ack_pending = false;
+    s_resp_pending = false;
+    s_resp_valid = false;
+    s_active = -1;
+    s_auth_sector = -1;
+    s_passive_retries = PN532_RFCFG_RETRY_FOREVER;
+    s_fault = PN532_SIM_FAULT_NONE;
+    s_bus = PN532_TRANSPORT_I2C;
+    s_hsu_baud = PN532_UART_BAUD_DEFAULT;
+    s_hsu_baud_next = 0;
+    s_host_baud = PN532_UART_BAUD_DEFAULT;
+    s_rx = NULL;
+}
+
+int pn532_sim_add_tag(const pn532_sim_tag_t *tag)
+{
+    if (s_tag_count >= PN532_SIM_MAX_TAGS) {
+        return -1;
+    }
+    s_tags[s_tag_count] = *tag;
+    return (int)s_tag_count++;
+}
+
+void pn532_sim_replace_tag(int idx, const pn532_sim_tag_t *tag)
+{
+    if (idx >= 0 && (unsigned)idx < s_tag_count) {
+        s_tags[idx] = *tag;
+        if (s_active == idx) {
+            s_active = -1;
+            s_auth_sector = -1;
+        }
+    }
+}
+
+void pn532_sim_set_tag_window(int idx, int64_t enter_us, int64_t leave_us)
+{
+    if (idx >= 0 && (unsigned)idx < s_tag_count) {
+        s_tags[idx].enter_us = enter_us;
+        s_tags[idx].leave_us = leave_us;
+    }
+}
+
+void pn532_sim_inject_fault(pn532_sim_fault_t fault, int64_t duration_us)
+{
+    s_fault = fault;
+    s_fault_until_us = host_clock_now_us() + duration_us;
+}
+
+void pn532_sim_get_stats(pn532_sim_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+void pn532_sim_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+static bool tag_present(int idx)
+{
+    int64_t now = host_clock_now_us();
+    return idx >= 0 && s_tags[idx].enter_us <= now && now < s_tags[idx].leave_us;
+}
+
+static bool tag_is_classic(const pn532_sim_tag_t *t)
+{
+    return t->brty == PN532_BAUDRATE_106K_ISO14443A && (t->sak == 0x08 || t->sak == 0x18);
+}
+
+/* Wire time of bytes characters at the HSU rate */
+static int64_t hsu_us(size_t bytes, uint32_t baud)
+{
+    return (int64_t)bytes * SIM_HSU_BITS_PER_BYTE * 1000000 / baud;
+}
+
+/*
+ * Every transaction costs its bytes on the wire: plus the address byte on
+ * I2C, plus the prefix byte and the set-up time on SPI.
+ */
+static void bus_transfer(size_t bytes, bool write)
+{
+    size_t wire = (s_bus == PN532_TRANSPORT_HSU) ? bytes : bytes + 1;
+    switch (s_bus) {
+        case PN532_TRANSPORT_SPI:
+            host_clock_advance_us(s_cfg.spi_txn_us + (int64_t)wire * 8 * 1000000 / s_cfg.spi_clock_hz);
+            break;
+        case PN532_TRANSPORT_HSU:
+            host_clock_advance_us(hsu_us(wire, s_host_baud));
+            break;
+        default:
+            host_clock_advance_us((int64_t)wire * s_cfg.bus_us_per_byte);
+            break;
+    }
+    s_stats.transactions++;
+    if (write) {
+        s_stats.bytes_written += wire;
+    } else {
+        s_stats.bytes_read += wire;
+    }
+}
+
+/* Wrap data (response code first) in a PN532 -> host frame, extended above LEN 255 */
+static void build_response(const uint8_t *data, size_t len)
+{
+    size_t frame_len = len + 1;
+    size_t i = 0;
+    s_resp[i++] = 0x00;
+    s_resp[i++] = 0x00;
+    s_resp[i++] = 0xFF;
+    if (frame_len > 0xFF) {
+        s_resp[i++] = 0xFF;
+        s_resp[i++] = 0xFF;
+        s_resp[i++] = (uint8_t)(frame_len >> 8);
+        s_resp[i++] = (uint8_t)frame_len;
+        s_resp[i++] = (uint8_t)(0x00 - (frame_len >> 8) - frame_len);
+    } else {
+        s_resp[i++] = (uint8_t)frame_len;
+        s_resp[i++] = (uint8_t)(0x00 - frame_len);
+    }
+    uint8_t dcs = PN532_TFI_PN532_TO_HOST;
+    s_resp[i++] = PN532_TFI_PN532_TO_HOST;
+    for (size_t k = 0; k < len; k++) {
+        s_resp[i++] = data[k];
+        dcs += data[k];
+    }
+    s_resp[i++] = (uint8_t)(0x00 - dcs);
+    s_resp[i++] = 0x00;
+    s_resp_len = i;
+}
+
+/* Block number -> Classic sector and its trailer block */
+static unsigned classic_sector(unsigned block, unsigned *trailer)
+{
+    if (block < 128) {
+        *trailer = (block / 4) * 4 + 3;
+        return block / 4;
+    }
+    unsigned sector = 32 + (block - 128) / 16;
+    *trailer = 128 + (sector - 32) * 16 + 15;
+    return sector;
+}
+
+/*
+ * Tag side of InDataExchange: out gets Status then DataIn, *air is the RF
+ * and tag processing time. Type 2 READ/FAST_READ/WRITE and Classic
+ * AUTH/READ are modelled; a Type 2 NAK comes back as one 0x00 byte.
+ */
+static size_t tag_exchange(const uint8_t *cmd, size_t n, uint8_t *out, uint32_t *air)
+{
+    pn532_sim_tag_t *t = &s_tags[s_active];
+    size_t len = 1;
+    out[0] = SIM_STATUS_OK;
+    *air = 0;
+
+    if (n >= 2 && cmd[0] == PN532_MIFARE_CMD_READ && tag_is_classic(t)) {
+        unsigned trailer;
+        unsigned block = cmd[1];
+        if ((int)classic_sector(block, &trailer) != s_auth_sector ||
+            (block + 1) * PN532_MIFARE_BLOCK_SIZE > t->mem_len) {
+            out[0] = SIM_STATUS_AUTH_ERROR;
+            return 1;
+        }
+        memcpy(out + 1, t->mem + block * PN532_MIFARE_BLOCK_SIZE, PN532_MIFARE_BLOCK_SIZE);
+        if (block == trailer) {
+            memset(out + 1, 0, PN532_MIFARE_KEY_LEN);   /* Key A never reads back */
+        }
+        len += PN532_MIFARE_BLOCK_SIZE;
+    } else if (n >= 2 && cmd[0] == PN532_NTAG_CMD_READ) {
+        for (size_t k = 0; k < PN532_NTAG_READ_LEN && t->mem_len > 0; k++) {
+            out[len++] = t->mem[(cmd[1] * PN532_NTAG_PAGE_SIZE + k) % t->mem_len];
+        }
+    } else if (n >= 3 && cmd[0] == PN532_NTAG_CMD_FAST_READ) {
+        size_t start = (size_t)cmd[1] * PN532_NTAG_PAGE_SIZE;
+        size_t end = ((size_t)cmd[2] + 1) * PN532_NTAG_PAGE_SIZE;
+        if (cmd[2] < cmd[1] || end > t->mem_len) {
+            out[len++] = 0x00;
+        } else {
+            memcpy(out + 1, t->mem + start, end - start);
+            len += end - start;
+        }
+    } else if (n >= 2 + PN532_NTAG_PAGE_SIZE && cmd[0] == PN532_NTAG_CMD_WRITE) {
+        size_t off = (size_t)cmd[1] * PN532_NTAG_PAGE_SIZE;
+        if (off + PN532_NTAG_PAGE_SIZE > t->mem_len) {
+            out[len++] = 0x00;
+        } else {
+            memcpy(t->mem + off, cmd + 2, PN532_NTAG_PAGE_SIZE);
+            *air += s_cfg.write_us;
+        }
+    } else if (n >= 2 + PN532_MIFARE_KEY_LEN && tag_is_classic(t) &&
+               (cmd[0] == PN532_MIFARE_CMD_AUTH_A || cmd[0] == PN532_MIFARE_CMD_AUTH_B)) {
+        unsigned trailer;
+        unsigned sector = classic_sector(cmd[1], &trailer);
+        size_t key_off = trailer * PN532_MIFARE_BLOCK_SIZE +
+                         (cmd[0] == PN532_MIFARE_CMD_AUTH_B ? SIM_CLASSIC_KEY_B_OFF : 0);
+        if (key_off + PN532_MIFARE_KEY_LEN <= t->mem_len &&
+            memcmp(t->mem + key_off, cmd + 2, PN532_MIFARE_KEY_LEN) == 0) {
+            s_auth_sector = (int)sector;
+        } else {
+            /* Wrong key: the card falls back to IDLE and must be activated again */
+            out[0] = SIM_STATUS_AUTH_ERROR;
+            s_active = -1;
+            s_auth_sector = -1;
+        }
+    } else {
+        out[0] = SIM_STATUS_TIMEOUT;
+        *air = SIM_RF_TIMEOUT_US;
+        return 1;
+    }
+    *air += (uint32_t)(n + len - 1) * s_cfg.rf_us_per_byte;
+    return len;
+}
+
+/* InListPassiveTarget, MaxTg 1: the first scripted tag in the field on that modulation */
+static size_t list_passive_target(const uint8_t *p, size_t n, uint8_t *out, uint32_t *extra, bool *silent)
+{
+    uint8_t brty = (n >= 2) ? p[1] : PN532_BAUDRATE_106K_ISO14443A;
+    int found = -1;
+    for (unsigned i = 0; i < s_tag_count && found < 0; i++) {
+        const pn532_sim_tag_t *t = &s_tags[i];
+        if (!tag_present((int)i) || t->brty != brty) {
+            continue;
+        }
+        /* 106A InitiatorData is a UID: only that card may answer */
+        if (brty == PN532_BAUDRATE_106K_ISO14443A && n > 2 &&
+            (n - 2 != t->uid_length || memcmp(p + 2, t->uid, t->uid_length) != 0)) {
+            continue;
+        }
+        found = (int)i;
+    }
+
+    size_t len = 0;
+    out[len++] = PN532_RSP_IN_LIST_PASSIVE_TARGET;
+    if (found < 0) {
+        /* Retries 0xFF: the PN532 keeps trying and never answers */
+        if (s_passive_retries == PN532_RFCFG_RETRY_FOREVER) {
+            *silent = true;
+        }
+        *extra = (uint32_t)(s_passive_retries + 1) * s_cfg.activation_us;
+        out[len++] = 0;
+        return len;
+    }
+
+    const pn532_sim_tag_t *t = &s_tags[found];
+    s_active = found;
+    s_auth_sector = -1;
+    s_stats.activations++;
+    out[len++] = 1;
+    out[len++] = 1;   /* Tg */
+    if (brty == PN532_BAUDRATE_212K_FELICA || brty == PN532_BAUDRATE_424K_FELICA) {
+        out[len++] = 2 + 2 * PN532_FELICA_IDM_LEN;   /* POL_RES length, counts itself */
+        out[len++] = 0x01;
+        memcpy(out + len, t->uid, PN532_FELICA_IDM_LEN);
+        len += PN532_FELICA_IDM_LEN;
+        memset(out + len, 0, PN532_FELICA_IDM_LEN);  /* PMm */
+        len += PN532_FELICA_IDM_LEN;
+    } else if (brty == PN532_BAUDRATE_106K_ISO14443B) {
+        out[len++] = 0x50;
+        memcpy(out + len, t->uid, PN532_ISO14443B_PUPI_LEN);
+        len += PN532_ISO14443B_PUPI_LEN;
+        memset(out + len, 0, 4);                     /* Application data */
+        len += 4;
+        out[len++] = 0x00;                           /* ProtInfo: ISO14443-4 */
+        out[len++] = 0x81;
+        out[len++] = 0x71;
+        out[len++] = 1;                              /* ATTRIB_RES */
+        out[len++] = 0x00;
+    } else {
+        out[len++] = t->atqa[0];
+        out[len++] = t->atqa[1];
+        out[len++] = t->sak;
+        out[len++] = t->uid_length;
+        memcpy(out + len, t->uid, t->uid_length);
+        len += t->uid_length;
+        if (t->sak & 0x20) {
+            memcpy(out + len, SIM_ATS, sizeof(SIM_ATS));
+            len += sizeof(SIM_ATS);
+        }
+    }
+    return len;
+}
+
+/*
+ * Run one command; out gets the response data (response code first).
+ * Returns the processing time after the ACK. *silent = no response at all.
+ */
+static size_t run_command(uint8_t cmd, const uint8_t *p, size_t n, uint8_t *out, uint32_t *latency,
+                          bool *silent)
+{
+    uint32_t extra = 0;
+    size_t len = 0;
+    *silent = false;
+    *latency = s_cfg.cmd_us[cmd] ? s_cfg.cmd_us[cmd] : s_cfg.default_cmd_us;
+
+    switch (cmd) {
+        case PN532_CMD_GET_FIRMWARE_VERSION: {
+            const uint8_t fw[] = { PN532_RSP_GET_FIRMWARE_VERSION, 0x32, 0x01, 0x06, 0x07 };
+            memcpy(out, fw, sizeof(fw));
+            len = sizeof(fw);
+            break;
+        }
+        case PN532_CMD_SET_SERIAL_BAUD_RATE:
+            if (n < 1 || p[0] >= sizeof(SIM_HSU_BAUD) / sizeof(SIM_HSU_BAUD[0])) {
+                return 0;
+            }
+            s_hsu_baud_next = SIM_HSU_BAUD[p[0]];
+            out[len++] = PN532_RSP_SET_SERIAL_BAUD_RATE;
+            break;
+        case PN532_CMD_SAM_CONFIGURATION:
+            out[len++] = (uint8_t)(cmd + 1);
+            break;
+        case PN532_CMD_RF_CONFIGURATION:
+            if (n >= 4 && p[0] == PN532_RFCFG_ITEM_MAX_RETRIES) {
+                s_passive_retries = p[3];
+            }
+            out[len++] = PN532_RSP_RF_CONFIGURATION;
+            break;
+        case PN532_CMD_IN_LIST_PASSIVE_TARGET:
+            len = list_passive_target(p, n, out, &extra, silent);
+            break;
+        case PN532_CMD_IN_RELEASE:
+            s_active = -1;
+            s_auth_sector = -1;
+            out[len++] = PN532_RSP_IN_RELEASE;
+            out[len++] = 0x00;
+            break;
+        case PN532_CMD_DIAGNOSE: {
+            const pn532_sim_tag_t *t = &s_tags[s_active < 0 ? 0 : s_active];
+            bool isodep = tag_present(s_active) &&
+                          ((t->sak & 0x20) || t->brty == PN532_BAUDRATE_106K_ISO14443B);
+            out[len++] = PN532_RSP_DIAGNOSE;
+            out[len++] = (n >= 1 && p[0] == PN532_DIAG_ATTENTION_REQUEST && !isodep) ? 0x01 : 0x00;
+            break;
+        }
+        case PN532_CMD_IN_DATA_EXCHANGE:
+            out[len++] = PN532_RSP_IN_DATA_EXCHANGE;
+            if (n < 1 || (p[0] & ~PN532_TG_MI) != 1 || !tag_present(s_active)) {
+                out[len++] = SIM_STATUS_TIMEOUT;
+                extra = SIM_RF_TIMEOUT_US;
+            } else {
+                len += tag_exchange(p + 1, n - 1, out + 1, &extra);
+            }
+            break;
+        default:
+            return 0;   /* Caller sends the error frame */
+    }
+    *latency += extra;
+    return len;
+}
+
+/* Validate a host command frame (normal or extended) and queue ACK + response */
+static void handle_frame(const uint8_t *f, size_t n)
+{
+    size_t len;
+    size_t hdr;
+    if (n < 8 || f[0] != 0x00 || f[1] != 0x00 || f[2] != 0xFF) {
+        return;   /* Wake-up bytes and line noise are ignored */
+    }
+    if (f[3] == 0xFF && f[4] == 0xFF) {
+        len = ((size_t)f[5] << 8) | f[6];
+        hdr = 8;
+        if ((uint8_t)(f[5] + f[6] + f[7]) != 0) {
+            s_stats.bad_frames++;
+            return;
+        }
+    } else {
+        len = f[3];
+        hdr = 5;
+        if ((uint8_t)(f[3] + f[4]) != 0) {
+            s_stats.bad_frames++;
+            return;
+        }
+    }
+    if (len < 2 || hdr + len + 2 > n || f[hdr] != PN532_TFI_HOST_TO_PN532) {
+        s_stats.bad_frames++;
+        return;
+    }
+    uint8_t sum = 0;
+    for (size_t k = 0; k <= len; k++) {
+        sum += f[hdr + k];
+    }
+    if (sum != 0) {
+        s_stats.bad_frames++;
+        return;
+    }
+
+    s_stats.commands++;
+    int64_t now = host_clock_now_us();
+    s_ack_pending = true;
+    s_ack_ready_us = now + s_cfg.ack_us;
+
+    uint8_t data[PN532_FRAME_MAX_DATA];
+    uint32_t latency = 0;
+    bool silent = false;
+    size_t out_len = run_command(f[hdr + 1], f + hdr + 2, len - 2, data, &latency, &silent);
+    if (silent) {
+        s_resp_pending = false;
+        s_resp_valid = false;
+        return;
+    }
+    if (out_len == 0) {
+        memcpy(s_resp, ERROR_FRAME, sizeof(ERROR_FRAME));
+        s_resp_len = sizeof(ERROR_FRAME);
+    } else {
+        build_response(data, out_len);
+    }
+    s_resp_pending = true;
+    s_resp_valid = true;
+    s_resp_ready_us = s_ack_ready_us + latency;
+}
+
+static bool frame_due(void)
+{
+    int64_t now = host_clock_now_us();
+    if (s_ack_pending) {
+        return now >= s_ack_ready_us;
+    }
+    return s_resp_pending && now >= s_resp_ready_us;
+}
+
+/*
+ * True while the injected fault refuses transactions. A brown-out ends with
+ * a power-on reset: pending frames, the selected target and RFConfiguration
+ * are lost.
+ */
+static bool sim_faulted(void)
+{
+    if (s_fault == PN532_SIM_FAULT_BROWNOUT && host_clock_now_us() >= s_fault_until_us) {
+        s_fault = PN532_SIM_FAULT_NONE;
+        s_ack_pending = false;
+        s_resp_pending = false;
+        s_resp_valid = false;
+        s_active = -1;
+        s_auth_sector = -1;
+        s_passive_retries = PN532_RFCFG_RETRY_FOREVER;
+        s_hsu_baud = PN532_UART_BAUD_DEFAULT;
+        s_hsu_baud_next = 0;
+    }
+    if (s_fault == PN532_SIM_FAULT_NONE) {
+        return false;
+    }
+    bus_transfer(0, false);
+    s_stats.failed_transactions++;
+    return true;
+}
+
+static pn532_err_t i2c_init(pn532_dev_t *dev)
+{
+    (void)dev;
+    s_bus = PN532_TRANSPORT_I2C;
+    return PN532_OK;
+}
+
+static pn532_err_t spi_init(pn532_dev_t *dev)
+{
+    (void)dev;
+    s_bus = PN532_TRANSPORT_SPI;
+    return PN532_OK;
+}
+
+/* A host frame fully received by the PN532 */
+static void receive_frame(const uint8_t *frame, size_t n)
+{
+    if (n == sizeof(ACK_FRAME) && memcmp(frame, ACK_FRAME, n) == 0) {
+        /* Host ACK aborts the command in progress, and completes a SetSerialBaudRate */
+        s_ack_pending = false;
+        s_resp_pending = false;
+        if (s_hsu_baud_next) {
+            s_hsu_baud = s_hsu_baud_next;
+            s_hsu_baud_next = 0;
+        }
+    } else if (n == sizeof(NACK_FRAME) && memcmp(frame, NACK_FRAME, n) == 0) {
+        s_stats.nacks++;
+        if (s_resp_valid) {
+            s_resp_pending = true;
+            s_resp_ready_us = host_clock_now_us();
+        }
+    } else {
+        s_hsu_baud_next = 0;
+        handle_frame(frame, n);
+    }
+}
+
+static pn532_err_t sim_writev(pn532_dev_t *dev, const pn532_iovec_t *iov, unsigned iovcnt)
+{
+    int64_t start = host_clock_now_us();
+    if (sim_faulted()) {
+        pn532_transport_record(dev, start, false);
+        return PN532_ERR_I2C;
+    }
+    uint8_t frame[PN532_FRAME_MAX_LEN + 16];
+    size_t n = 0;
+    for (unsigned k = 0; k < iovcnt; k++) {
+        if (n + iov[k].len > sizeof(frame)) {
+            return PN532_ERR_SIZE;
+        }
+        memcpy(frame + n, iov[k].data, iov[k].len);
+        n += iov[k].len;
+    }
+    bus_transfer(n, true);
+    receive_frame(frame, n);
+    pn532_transport_record(dev, start, true);
+    return PN532_OK;
+}
+
+/* One read transaction of wire_bytes; buf gets the ready byte and len - 1 frame bytes */
+static pn532_err_t bus_read(pn532_dev_t *dev, uint8_t *buf, size_t len, size_t wire_bytes)
+{
+    int64_t start = host_clock_now_us();
+    if (sim_faulted()) {
+        pn532_transport_record(dev, start, false);
+        return PN532_ERR_I2C;
+    }
+    bus_transfer(wire_bytes, false);
+    if (len == 0) {
+        return PN532_OK;
+    }
+    memset(buf, 0, len);
+    if (!frame_due()) {
+        s_stats.not_ready_reads++;
+    } else {
+        const uint8_t *frame = s_resp;
+        size_t frame_len = s_resp_len;
+        if (s_ack_pending) {
+            frame = ACK_FRAME;
+            frame_len = sizeof(ACK_FRAME);
+            s_ack_pending = false;
+        } else {
+            s_resp_pending = false;
+        }
+        buf[0] = PN532_I2C_READY;
+        memcpy(buf + 1, frame, (len - 1 < frame_len) ? len - 1 : frame_len);
+    }
+    pn532_transport_record(dev, start, true);
+    return PN532_OK;
+}
+
+/* I2C: address byte, then the ready byte and the frame */
+static pn532_err_t i2c_read(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    return bus_read(dev, buf, len, len);
+}
+
+/* SPI: the DR prefix takes the place of the ready byte, which the backend fills in (doc §7.5) */
+static pn532_err_t spi_read(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    return bus_read(dev, buf, len, len ? len - 1 : 0);
+}
+
+/* I2C status read, or SPI SR prefix + status byte: two bytes on the wire either way */
+static bool sim_is_ready(pn532_dev_t *dev)
+{
+    int64_t start = host_clock_now_us();
+    if (sim_faulted()) {
+        pn532_transport_record(dev, start, false);
+        return false;
+    }
+    bus_transfer(1, false);
+    bool ready = frame_due();
+    if (!ready) {
+        s_stats.not_ready_reads++;
+    }
+    pn532_transport_record(dev, start, true);
+    return ready;
+}
+
+/* Clears a stuck bus; a brown-out PN532 stays silent until its time is up */
+static pn532_err_t sim_recover(pn532_dev_t *dev)
+{
+    (void)dev;
+    host_clock_advance_us(SIM_RECOVER_US);
+    s_stats.bus_recoveries++;
+    if (s_fault == PN532_SIM_FAULT_BUS_STUCK) {
+        s_fault = PN532_SIM_FAULT_NONE;
+    }
+    return PN532_OK;
+}
+
+/*
+ * HSU (doc §7.6). The PN532 starts transmitting a frame once it is due; byte
+ * i has arrived one character time per byte later. At mismatched rates the
+ * frame is noise, so it is lost on either side.
+ */
+static pn532_err_t hsu_init(pn532_dev_t *dev)
+{
+    s_bus = PN532_TRANSPORT_HSU;
+    s_host_baud = PN532_UART_BAUD_DEFAULT;
+    dev->bus_baud = s_host_baud;
+    return PN532_OK;
+}
+
+/* The frame the PN532 sends next and when it starts; false if none is pending */
+static bool hsu_next_frame(const uint8_t **frame, size_t *len, int64_t *start_us)
+{
+    if (s_ack_pending) {
+        *frame = ACK_FRAME;
+        *len = sizeof(ACK_FRAME);
+        *start_us = s_ack_ready_us;
+        return true;
+    }
+    if (s_resp_pending) {
+        *frame = s_resp;
+        *len = s_resp_len;
+        *start_us = s_resp_ready_us;
+        return true;
+    }
+    return false;
+}
+
+/* Start receiving the next frame if it starts by until_us */
+static bool hsu_rx_start(int64_t until_us)
+{
+    const uint8_t *frame;
+    size_t len;
+    int64_t start_us;
+    if (!hsu_next_frame(&frame, &len, &start_us) || start_us > until_us) {
+        return false;
+    }
+    if (s_ack_pending) {
+        s_ack_pending = false;
+    } else {
+        s_resp_pending = false;
+    }
+    if (s_host_baud != s_hsu_baud) {
+        return false;
+    }
+    s_rx = frame;
+    s_rx_len = len;
+    s_rx_pos = 0;
+    s_rx_start_us = start_us;
+    return true;
+}
+
+/* A new command makes anything received so far stale, as hsu_writev() flushes it */
+static pn532_err_t hsu_writev(pn532_dev_t *dev, const pn532_iovec_t *iov, unsigned iovcnt)
+{
+    s_rx = NULL;
+    if (s_host_baud == s_hsu_baud) {
+        return sim_writev(dev, iov, iovcnt);
+    }
+    int64_t start = host_clock_now_us();
+    size_t n = 0;
+    for (unsigned k = 0; k < iovcnt; k++) {
+        n += iov[k].len;
+    }
+    bus_transfer(n, true);
+    s_stats.bad_frames++;
+    pn532_transport_record(dev, start, true);
+    return PN532_OK;
+}
+
+/* uart_read_bytes(): len bytes, or a timeout PN532_UART_READ_TIMEOUT_MS after the call */
+static pn532_err_t hsu_read_continue(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    if (len == 0) {
+        return PN532_OK;
+    }
+    int64_t start = host_clock_now_us();
+    int64_t deadline = start + (int64_t)PN532_UART_READ_TIMEOUT_MS * 1000;
+    size_t got = 0;
+    if (!sim_faulted()) {
+        while (got < len && (s_rx || hsu_rx_start(deadline))) {
+            size_t k = (len - got < s_rx_len - s_rx_pos) ? len - got : s_rx_len - s_rx_pos;
+            memcpy(buf + got, s_rx + s_rx_pos, k);
+            got += k;
+            s_rx_pos += k;
+            host_clock_advance_to_us(s_rx_start_us + hsu_us(s_rx_pos, s_hsu_baud));
+            if (s_rx_pos == s_rx_len) {
+                s_rx = NULL;
+            }
+        }
+    }
+    s_stats.transactions++;
+    s_stats.bytes_read += got;
+    if (got < len) {
+        host_clock_advance_to_us(deadline);
+        pn532_transport_record(dev, start, false);
+        return PN532_ERR_TIMEOUT;
+    }
+    pn532_transport_record(dev, start, true);
+    return PN532_OK;
+}
+
+static pn532_err_t hsu_read(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    if (len == 0) {
+        return PN532_OK;
+    }
+    buf[0] = PN532_I2C_READY;
+    return hsu_read_continue(dev, buf + 1, len - 1);
+}
+
+/* Bytes in the RX buffer; a local register read, no wire time */
+static bool hsu_is_ready(pn532_dev_t *dev)
+{
+    (void)dev;
+    const uint8_t *frame;
+    size_t len;
+    int64_t start_us;
+    bool ready = s_rx != NULL ||
+                 (s_host_baud == s_hsu_baud && hsu_next_frame(&frame, &len, &start_us) &&
+                  host_clock_now_us() >= start_us + hsu_us(1, s_hsu_baud));
+    if (!ready) {
+        s_stats.not_ready_reads++;
+    }
+    return ready;
+}
+
+/* uart_get_buffered_data_len(): bytes of the frame on the line that have arrived and not been read */
+static size_t hsu_buffered(pn532_dev_t *dev)
+{
+    (void)dev;
+    const uint8_t *frame = s_rx;
+    size_t len = s_rx_len;
+    size_t pos = s_rx_pos;
+    int64_t start_us = s_rx_start_us;
+    if (!frame) {
+        if (sim_faulted() || s_host_baud != s_hsu_baud || !hsu_next_frame(&frame, &len, &start_us)) {
+            return 0;
+        }
+        pos = 0;
+    }
+    int64_t elapsed_us = host_clock_now_us() - start_us;
+    size_t arrived = (elapsed_us <= 0) ? 0
+                     : (size_t)(elapsed_us * s_hsu_baud / (SIM_HSU_BITS_PER_BYTE * 1000000LL));
+    if (arrived > len) {
+        arrived = len;
+    }
+    return (arrived > pos) ? arrived - pos : 0;
+}
+
+/*
+ * The UART_DATA event: posted once SIM_HSU_FIFO_FULL bytes have arrived, or
+ * SIM_HSU_RX_TOUT idle characters after the last byte of a shorter frame.
+ */
+static pn532_err_t hsu_wait_ready(pn532_dev_t *dev, uint32_t timeout_ms)
+{
+    (void)dev;
+    int64_t deadline = host_clock_now_us() + (int64_t)timeout_ms * 1000;
+    const uint8_t *frame;
+    size_t len;
+    int64_t start_us;
+    if (s_rx) {
+        return PN532_OK;
+    }
+    if (!sim_faulted() && s_host_baud == s_hsu_baud && hsu_next_frame(&frame, &len, &start_us)) {
+        size_t chars = (len < SIM_HSU_FIFO_FULL) ? len + SIM_HSU_RX_TOUT : SIM_HSU_FIFO_FULL;
+        int64_t event_us = start_us + hsu_us(chars, s_hsu_baud);
+        if (event_us <= deadline) {
+            host_clock_advance_to_us(event_us);
+            return PN532_OK;
+        }
+    }
+    host_clock_advance_to_us(deadline);
+    return PN532_ERR_TIMEOUT;
+}
+
+/* Takes effect at once: the driver has waited for its ACK to leave at the old rate */
+static pn532_err_t hsu_set_baud(pn532_dev_t *dev, uint32_t baud)
+{
+    s_host_baud = baud;
+    dev->bus_baud = baud;
+    s_rx = NULL;
+    return PN532_OK;
+}
+
+/* pn532_init() picks one of these by config.transport; the ops match the real backends' */
+const pn532_transport_ops_t pn532_i2c_transport = {
+    .name     = "SIM I2C",
+    .init     = i2c_init,
+    .writev   = sim_writev,
+    .read     = i2c_read,
+    .is_ready = sim_is_ready,
+    .recover  = sim_recover,
+};
+
+const pn532_transport_ops_t pn532_spi_transport = {
+    .name     = "SIM SPI",
+    .init     = spi_init,
+    .writev   = sim_writev,
+    .read     = spi_read,
+    .is_ready = sim_is_ready,
+};
+
+const pn532_transport_ops_t pn532_hsu_transport = {
+    .name          = "SIM HSU",
+    .init          = hsu_init,
+    .writev        = hsu_writev,
+    .read          = hsu_read,
+    .is_ready      = hsu_is_ready,
+    .read_continue = hsu_read_continue,
+    .buffered      = hsu_buffered,
+    .wait_ready    = hsu_wait_ready,
+    .set_baud      = hsu_set_baud,
+};
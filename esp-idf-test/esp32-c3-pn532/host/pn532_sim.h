@@ -0,0 +1,83 @@
+/**
+ * Simulated PN532 for host builds (TECHNICAL_DOCUMENTATION.md §19). It
+ * exports the three transport symbols pn532.c selects from, so the real
+ * driver links against it unchanged and config.transport picks the bus:
+ * I2C with its ready byte, SPI with its prefix byte, or HSU streaming at the
+ * negotiated baud rate. Modelled: ACK/NACK, normal and extended frames with
+ * LCS/DCS checks, per-command latency on the virtual clock, wire time per
+ * byte, scripted tags entering and leaving the field, and injected faults.
+ */
+
+#ifndef PN532_SIM_H
+#define PN532_SIM_H
+
+#include "pn532.h"
+
+#define PN532_SIM_MAX_TAGS  16
+
+/* A scripted tag; present while enter_us <= now < leave_us */
+typedef struct {
+    uint8_t brty;                    /* PN532_BAUDRATE_* it answers */
+    uint8_t uid[PN532_MAX_UID_LEN];  /* 106A UID, FeliCa IDm or type B PUPI */
+    uint8_t uid_length;
+    uint8_t sak;                     /* 106A only */
+    uint8_t atqa[2];
+    uint8_t *mem;                    /* Type 2 pages or Classic blocks; NULL for none */
+    size_t mem_len;
+    int64_t enter_us;
+    int64_t leave_us;
+} pn532_sim_tag_t;
+
+/* Latencies in virtual microseconds */
+typedef struct {
+    uint32_t bus_us_per_byte;        /* I2C wire time, 90 at 100 kHz (9 clocks per byte) */
+    uint32_t spi_clock_hz;           /* SPI wire time is 8 clocks per byte */
+    uint32_t spi_txn_us;             /* SPI: CS and DMA set-up per transaction */
+    uint32_t ack_us;                 /* Command frame written -> ACK ready */
+    uint32_t cmd_us[256];            /* ACK -> response ready, by command code; 0 = default_cmd_us */
+    uint32_t default_cmd_us;
+    uint32_t activation_us;          /* InListPassiveTarget: per activation attempt on an empty field */
+    uint32_t rf_us_per_byte;         /* InDataExchange: air time per byte each way (106 kbps) */
+    uint32_t write_us;               /* Type 2 WRITE: EEPROM programming */
+} pn532_sim_config_t;
+
+typedef struct {
+    uint32_t commands;               /* Valid command frames */
+    uint32_t bad_frames;             /* LCS/DCS/TFI errors; dropped without an ACK */
+    uint32_t nacks;                  /* Response re-sends requested by the host */
+    uint32_t not_ready_reads;        /* Reads while nothing was ready */
+    uint64_t bytes_written;          /* Host -> PN532, incl. address byte */
+    uint64_t bytes_read;             /* PN532 -> host, incl. address byte */
+    uint32_t transactions;
+    uint32_t failed_transactions;    /* Refused while a fault was active */
+    uint32_t bus_recoveries;         /* Transport recover calls */
+    uint32_t activations;            /* InListPassiveTarget that selected a tag, re-selects included */
+} pn532_sim_stats_t;
+
+typedef enum {
+    PN532_SIM_FAULT_NONE,
+    PN532_SIM_FAULT_BUS_STUCK,       /* SDA held low: every transaction fails until the bus is recovered */
+    PN532_SIM_FAULT_BROWNOUT,        /* No answer for a while, then back at power-on defaults */
+} pn532_sim_fault_t;
+
+void pn532_sim_config_default(pn532_sim_config_t *cfg);
+
+/* Reset the device, tags and counters. cfg NULL = defaults. */
+void pn532_sim_init(const pn532_sim_config_t *cfg);
+
+/* Index of the new tag, or -1 when PN532_SIM_MAX_TAGS are scripted */
+int pn532_sim_add_tag(const pn532_sim_tag_t *tag);
+
+/* Put a different tag in slot idx, e.g. the next card of a batch; an active old one is deselected */
+void pn532_sim_replace_tag(int idx, const pn532_sim_tag_t *tag);
+
+/* Move a scripted tag, e.g. take it out of the field now */
+void pn532_sim_set_tag_window(int idx, int64_t enter_us, int64_t leave_us);
+
+/* Start a fault now; duration_us applies to PN532_SIM_FAULT_BROWNOUT only */
+void pn532_sim_inject_fault(pn532_sim_fault_t fault, int64_t duration_us);
+
+void pn532_sim_get_stats(pn532_sim_stats_t *stats);
+void pn532_sim_reset_stats(void);
+
+#endif /* PN532_SIM_H */
@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_ROM_SYS_H
+#define HOST_ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+/* Busy wait; advances the virtual clock (host_port.c) */
+void esp_rom_delay_us(uint32_t us);
+
+#endif /* HOST_ESP_ROM_SYS_H */
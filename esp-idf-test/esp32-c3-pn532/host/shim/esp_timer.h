@@ -0,0 +1,9 @@
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+/* Virtual microseconds since start (host_port.c) */
+int64_t esp_timer_get_time(void);
+
+#endif /* HOST_ESP_TIMER_H */
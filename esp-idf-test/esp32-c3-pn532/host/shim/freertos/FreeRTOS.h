@@ -0,0 +1,29 @@
+/**
+ * Host shim: the slice of FreeRTOS the PN532 driver uses, on the simulator's
+ * virtual clock (host_port.c). Tick rate matches sdkconfig (100 Hz).
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* IDF gets this through portmacro.h; pn532.c relies on it for IRAM_ATTR */
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+
+#define configTICK_RATE_HZ  100
+#define portTICK_PERIOD_MS  (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+#define portMAX_DELAY       0xFFFFFFFFu
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+#define portYIELD_FROM_ISR(woken) ((void)(woken))
+
+#endif /* HOST_FREERTOS_H */
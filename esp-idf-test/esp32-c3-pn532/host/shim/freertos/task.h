@@ -0,0 +1,17 @@
+#ifndef HOST_FREERTOS_TASK_H
+#define HOST_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+/* Advances the virtual clock; there is only one task on the host */
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken);
+/* Never runs fn: the caller drives what the task would do (e.g. nfc_events_dispatch()) */
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio,
+                       TaskHandle_t *handle);
+
+#endif /* HOST_FREERTOS_TASK_H */
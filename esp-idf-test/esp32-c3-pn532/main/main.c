@@ -4,24 +4,140 @@
  */
 
 #include "pn532.h"
+#include "ndef.h"
+#include "tag_cache.h"
+#include "nfc_sched.h"
+#include "nfc_events.h"
+#include "nfc_cadence.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include <stdio.h>
 #include <string.h>
 
+/*
+ * Frame buffers live in the device handle and NDEF buffers are static, so
+ * the deepest tag read needs well under this; the STACK line of
+ * NFC_STATS_LOG_MS prints the measured headroom.
+ */
 #define POLL_TASK_STACK   4096
 #define POLL_TASK_PRIO    5
 
+/* 1 = let the PN532 poll on its own with InAutoPoll (doc §6.6) */
+#define NFC_USE_AUTOPOLL      0
+#define NFC_AUTOPOLL_PERIOD   1   /* x150 ms between autopoll rounds */
+
+/*
+ * RF defaults applied at init (doc §6.9). One activation retry makes an empty
+ * field answer NbTg=0 within a few ms instead of running into
+ * PN532_TAG_DETECT_TIMEOUT_MS; 25.6 ms is ample for NTAG/MIFARE replies.
+ */
+#define NFC_PASSIVE_RETRIES   0x01
+#define NFC_NONDEP_TIMEOUT    0x09  /* 100 us * 2^(9-1) = 25.6 ms */
+
+/*
+ * Modulations polled while the field is empty (doc §12.4). Types seen often
+ * get most slots; any type waits at most NFC_SCHED_MAX_GAP slots, i.e.
+ * NFC_SCHED_MAX_GAP times the current poll interval worst-case detection latency.
+ */
+#define NFC_SCHED_MAX_GAP     6
+#define NFC_SCHED_MIN_WEIGHT  64   /* 1/16 of a type that answers every poll */
+#define NFC_SCHED_RATE_SHIFT  4
+
+/*
+ * Empty-field poll cadence (doc §12.6): NFC_CADENCE_FAST_MS for
+ * NFC_CADENCE_HOLD_MS after a tag leaves or user input, then doubling every
+ * NFC_CADENCE_DECAY_MS up to NFC_CADENCE_SLOW_MS (idle after ~25 s).
+ */
+#define NFC_CADENCE_FAST_MS   30
+#define NFC_CADENCE_SLOW_MS   500
+#define NFC_CADENCE_HOLD_MS   5000
+#define NFC_CADENCE_DECAY_MS  5000
+#define NFC_CADENCE_DECAY     NFC_CADENCE_DECAY_EXPONENTIAL
+
+/* Probe or re-list interval while a tag is on the reader (doc §10.5, §12.6) */
+#define NFC_PRESENCE_INTERVAL_MS  100
+
+/*
+ * Consecutive communication errors before the bus and reader are recovered
+ * (doc §15.4). The first error is retried at once, so a stuck bus is usually
+ * cleared well within one poll interval.
+ */
+#define NFC_RECOVER_AFTER_ERRORS  2
+
+/* Print the driver's command statistics (doc §15.3) and event queue counters this often; 0 = never */
+#define NFC_STATS_LOG_MS      0
+
+/*
+ * 1 = measure the bus once after init and print a BENCH line (no polling).
+ * Flash once per interface strapping (I2C/SPI/HSU) and compare the lines.
+ */
+#define NFC_BENCHMARK         0
+#define NFC_BENCH_ROUNDS      50
+#define NFC_BENCH_LAST_PAGE   0x27  /* FAST_READ 4..0x27: NTAG213 user area, on every NTAG21x */
+
+/*
+ * 1 = provisioning station instead of the player (doc §10.7): read one NDEF
+ * message as a hex line from the console, then write it to every NTAG placed
+ * on the reader and print a PROV line per tag.
+ */
+#define NFC_PROVISION         0
+#define NFC_PROVISION_VERIFY  1  /* FAST_READ the image back after writing */
+#define NFC_CONSOLE_IDLE_MS   20
+
+/* The reader this firmware drives; a second one would get its own handle */
+static pn532_dev_t s_pn532;
+static TaskHandle_t s_poll_task = NULL;
+
 /* Callbacks (doc §16.1) - set before nfc_start_scanning */
 static void (*s_tag_detected_cb)(const pn532_tag_info_t *tag) = NULL;
 static void (*s_tag_removed_cb)(void) = NULL;
 
+/* Raw NDEF data of the last tag: NTAG216 user memory is 888 bytes, Type 4 content tags a few KB */
+#define NFC_NDEF_BUF_LEN  4096
+#define NFC_TYPE2_DATA_MAX 888  /* also keeps Type 2 page numbers within 8 bits */
+static uint8_t s_ndef_buf[NFC_NDEF_BUF_LEN];
+/*
+ * NDEF message handed from the polling task to the event consumer (doc §12.5).
+ * The polling task copies it only when the lock is free at once; while the
+ * consumer holds it to print, the copy is skipped instead of waited for.
+ */
+typedef struct {
+    uint8_t uid[PN532_MAX_UID_LEN];
+    uint8_t uid_length;
+    bool fresh;                /* Copied and not printed yet */
+    uint32_t cache_hits;       /* tag_cache counters at copy time; the cache is the polling task's */
+    uint32_t cache_misses;
+    size_t len;
+    uint8_t msg[NFC_NDEF_BUF_LEN];
+} nfc_ndef_handoff_t;
+
+static nfc_ndef_handoff_t s_ndef_out;
+static SemaphoreHandle_t s_ndef_out_lock;
+static StaticSemaphore_t s_ndef_out_lock_buf;
+static uint32_t s_ndef_out_skipped = 0;
+
+/* MIFARE Classic MAD and the sector being read, kept off the polling task stack */
+static uint8_t s_classic_mad[4 * PN532_MIFARE_BLOCK_SIZE];
+static uint8_t s_classic_sector[4 * PN532_MIFARE_BLOCK_SIZE];
+
 /* Polling state (doc §12.1, §13.3) */
 static uint8_t s_last_uid[PN532_MAX_UID_LEN];
 static uint8_t s_last_uid_length = 0;
 static int64_t s_last_detection_time_ms = 0;
 static bool s_tag_was_present = false;
 static unsigned s_consecutive_misses = 0;
+#if !NFC_USE_AUTOPOLL
+static nfc_cadence_t s_cadence;       /* Empty-field poll interval (doc §12.6) */
+#endif
+
+/* Communication error streak and completed outages, for time to recovery (doc §15.4) */
+static unsigned s_comm_errors = 0;
+static int64_t s_outage_start_us = 0;
+static uint32_t s_outages = 0;
+static uint64_t s_outage_total_us = 0;
+static bool s_config_stale = false;   /* Recovery failed; the PN532 may come back unconfigured */
 
 static bool compare_uid(const uint8_t *a, uint8_t len_a, const uint8_t *b, uint8_t len_b)
 {
@@ -45,11 +161,13 @@ static const char *tag_type_str(pn532_tag_type_t type)
         case PN532_TAG_MIFARE_CLASSIC_4K: return "MIFARE Classic 4K";
         case PN532_TAG_MIFARE_PLUS:       return "MIFARE Plus";
         case PN532_TAG_MIFARE_DESFIRE:    return "MIFARE DESFire";
+        case PN532_TAG_FELICA:            return "FeliCa";
+        case PN532_TAG_ISO14443B:         return "ISO14443-4B";
         default:                          return "Unknown";
     }
 }
 
-/* Debug: tag detected (doc §14.1) */
+/* Debug: tag detected (doc §14.1); runs in the event consumer task (doc §12.5) */
 static void on_tag_detected(const pn532_tag_info_t *tag)
 {
     printf("========================================\n");
@@ -72,7 +190,171 @@ static void on_tag_detected(const pn532_tag_info_t *tag)
     }
 }
 
-/* Debug: tag removed (doc §14.2) */
+/*
+ * Debug: NDEF records of the tag just detected (doc §10.4); runs in the event
+ * consumer task. Several events for one copy print it once.
+ */
+static void on_ndef_message(const nfc_event_t *ev)
+{
+    xSemaphoreTake(s_ndef_out_lock, portMAX_DELAY);
+    if (s_ndef_out.fresh && compare_uid(s_ndef_out.uid, s_ndef_out.uid_length, ev->uid, ev->uid_length)) {
+        s_ndef_out.fresh = false;
+        ndef_reader_t reader;
+        ndef_record_t rec;
+        ndef_reader_init(&reader, (ndef_view_t){ s_ndef_out.msg, s_ndef_out.len });
+        printf("NFC: NDEF message, %u bytes (cache %lu hits / %lu misses)\n", (unsigned)s_ndef_out.len,
+               (unsigned long)s_ndef_out.cache_hits, (unsigned long)s_ndef_out.cache_misses);
+        while (ndef_next_record(&reader, &rec) == NDEF_OK) {
+            printf("  Record TNF %u type '%.*s' payload %u bytes\n", (unsigned)rec.tnf,
+                   (int)rec.type.len, (const char *)rec.type.ptr, (unsigned)rec.payload.len);
+        }
+    }
+    xSemaphoreGive(s_ndef_out_lock);
+}
+
+/*
+ * Read the NDEF message of a Type 2 tag (doc §10.3, §10.4). One READ of page 3
+ * returns the CC plus the first 12 data-area bytes; further FAST_READs fetch
+ * only as far as the NDEF TLV length says the message goes.
+ */
+static bool read_tag_ndef(const pn532_tag_info_t *tag, ndef_view_t *msg)
+{
+    uint8_t first[PN532_NTAG_READ_LEN];
+    if (pn532_ntag_read(&s_pn532, tag->tg, 3, first) != PN532_OK) {
+        return false;
+    }
+    ndef_cc_t cc;
+    if (ndef_parse_cc(first, &cc) != NDEF_OK) {
+        return false;
+    }
+
+    size_t have = PN532_NTAG_READ_LEN - NDEF_CC_LEN;
+    memcpy(s_ndef_buf, first + NDEF_CC_LEN, have);
+
+    for (;;) {
+        size_t needed = 0;
+        ndef_err_t nerr = ndef_find_message(s_ndef_buf, have, msg, &needed);
+        if (nerr == NDEF_OK) {
+            return true;
+        }
+        if (nerr != NDEF_ERR_INCOMPLETE || needed > cc.data_area_size ||
+            needed > NFC_TYPE2_DATA_MAX) {
+            return false;
+        }
+
+        /* Data area starts at page 4; have is always a whole number of pages */
+        uint8_t start = (uint8_t)(4 + have / PN532_NTAG_PAGE_SIZE);
+        uint8_t end = (uint8_t)(4 + (needed - 1) / PN532_NTAG_PAGE_SIZE);
+        if (pn532_ntag_fast_read(&s_pn532, tag->tg, start, end, s_ndef_buf + have,
+                                 sizeof(s_ndef_buf) - have) != PN532_OK) {
+            return false;
+        }
+        have = (size_t)(end - 3) * PN532_NTAG_PAGE_SIZE;
+    }
+}
+
+/* Type 4 (ISO14443-4, e.g. DESFire): the NDEF file holds the bare message (doc §10.6) */
+static bool read_type4_ndef(const pn532_tag_info_t *tag, ndef_view_t *msg)
+{
+    size_t len = 0;
+    if (pn532_type4_read_ndef(&s_pn532, tag->tg, s_ndef_buf, sizeof(s_ndef_buf), &len) != PN532_OK ||
+        len == 0) {
+        return false;
+    }
+    msg->ptr = s_ndef_buf;
+    msg->len = len;
+    return true;
+}
+
+/*
+ * MIFARE Classic keys, tried after the one that last worked for the UID
+ * (doc §10.8): MAD sector key, NFC Forum public key, factory default.
+ */
+static const pn532_mifare_key_t NFC_CLASSIC_KEYS[] = {
+    { PN532_MIFARE_CMD_AUTH_A, { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 } },
+    { PN532_MIFARE_CMD_AUTH_A, { 0xD3, 0xF7, 0xD3, 0xF7, 0xD3, 0xF7 } },
+    { PN532_MIFARE_CMD_AUTH_A, { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF } },
+};
+
+/* MAD1 application ID of an NDEF sector, as stored (little endian 0xE103) */
+#define NFC_MAD_NDEF_AID0     0x03
+#define NFC_MAD_NDEF_AID1     0xE1
+#define NFC_MAD_SECTORS       16
+
+/*
+ * MIFARE Classic NDEF (doc §10.8): sector 0 holds the MAD, whose entries mark
+ * the NDEF sectors; their data blocks, trailers left out, form the TLV area
+ * of §10.4. Sectors are read only until the message TLV is complete.
+ */
+static bool read_classic_ndef(const pn532_tag_info_t *tag, ndef_view_t *msg)
+{
+    pn532_tag_info_t t = *tag;   /* tg changes when a key search re-activates the card */
+    size_t len = 0;
+    if (pn532_mifare_read_sector(&s_pn532, &t, 0, NFC_CLASSIC_KEYS,
+                                 sizeof(NFC_CLASSIC_KEYS) / sizeof(NFC_CLASSIC_KEYS[0]),
+                                 s_classic_mad, sizeof(s_classic_mad), &len) != PN532_OK) {
+        return false;
+    }
+
+    /* Block 1: CRC, info, AIDs of sectors 1-7; block 2: sectors 8-15 */
+    const uint8_t *aids = s_classic_mad + PN532_MIFARE_BLOCK_SIZE;
+    const size_t data_len = 3 * PN532_MIFARE_BLOCK_SIZE;
+    size_t have = 0;
+    for (unsigned s = 1; s < NFC_MAD_SECTORS && have + data_len <= sizeof(s_ndef_buf); s++) {
+        const uint8_t *aid = aids + 2 * s;
+        if (aid[0] != NFC_MAD_NDEF_AID0 || aid[1] != NFC_MAD_NDEF_AID1) {
+            if (have > 0) {
+                break;   /* NDEF sectors are contiguous */
+            }
+            continue;
+        }
+        if (pn532_mifare_read_sector(&s_pn532, &t, (uint8_t)s, NFC_CLASSIC_KEYS,
+                                     sizeof(NFC_CLASSIC_KEYS) / sizeof(NFC_CLASSIC_KEYS[0]),
+                                     s_classic_sector, sizeof(s_classic_sector), &len) != PN532_OK) {
+            return false;
+        }
+        memcpy(s_ndef_buf + have, s_classic_sector, data_len);
+        have += data_len;
+
+        size_t needed = 0;
+        ndef_err_t nerr = ndef_find_message(s_ndef_buf, have, msg, &needed);
+        if (nerr == NDEF_OK) {
+            return true;
+        }
+        if (nerr != NDEF_ERR_INCOMPLETE) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/*
+ * NDEF message for tag, from the UID-keyed cache when the same tag was seen
+ * before, otherwise read from the tag and cached. The view is valid until the
+ * next call.
+ */
+static bool load_tag_ndef(const pn532_tag_info_t *tag, ndef_view_t *msg)
+{
+    bool type2 = (tag->type == PN532_TAG_NTAG || tag->type == PN532_TAG_MIFARE_ULTRALIGHT);
+    bool type4 = (tag->sak & 0x20) != 0 || tag->type == PN532_TAG_ISO14443B;
+    bool classic = (tag->type == PN532_TAG_MIFARE_CLASSIC_1K || tag->type == PN532_TAG_MIFARE_CLASSIC_4K);
+    if (!type2 && !type4 && !classic) {
+        return false;
+    }
+
+    if (tag_cache_lookup(tag->uid, tag->uid_length, 0, &msg->ptr, &msg->len)) {
+        return true;
+    }
+    bool ok = type2 ? read_tag_ndef(tag, msg) : classic ? read_classic_ndef(tag, msg)
+                                                  : read_type4_ndef(tag, msg);
+    if (!ok) {
+        return false;
+    }
+    (void)tag_cache_store(tag->uid, tag->uid_length, 0, msg->ptr, msg->len);
+    return true;
+}
+
+/* Debug: tag removed (doc §14.2); runs in the event consumer task */
 static void on_tag_removed(void)
 {
     printf("NFC: Tag removed\n");
@@ -81,6 +363,54 @@ static void on_tag_removed(void)
     }
 }
 
+/* Consumer side of the event queue: the callbacks may take as long as they need */
+static void nfc_dispatch(const nfc_event_t *ev, void *ctx)
+{
+    (void)ctx;
+    if (ev->kind == NFC_EVENT_TAG_DETECTED) {
+        pn532_tag_info_t tag;
+        nfc_event_to_tag_info(ev, &tag);
+        on_tag_detected(&tag);
+    } else if (ev->kind == NFC_EVENT_NDEF_MESSAGE) {
+        on_ndef_message(ev);
+    } else {
+        on_tag_removed();
+    }
+}
+
+/* Polling side: copy the message out for the consumer and queue its event, never blocks */
+static void post_ndef_message(const pn532_tag_info_t *tag, ndef_view_t msg)
+{
+    if (msg.len > sizeof(s_ndef_out.msg) || xSemaphoreTake(s_ndef_out_lock, 0) != pdTRUE) {
+        s_ndef_out_skipped++;
+        return;
+    }
+    tag_cache_stats_t cs;
+    tag_cache_get_stats(&cs);
+    memcpy(s_ndef_out.uid, tag->uid, tag->uid_length);
+    s_ndef_out.uid_length = tag->uid_length;
+    s_ndef_out.cache_hits = cs.hits;
+    s_ndef_out.cache_misses = cs.misses;
+    memcpy(s_ndef_out.msg, msg.ptr, msg.len);
+    s_ndef_out.len = msg.len;
+    s_ndef_out.fresh = true;
+    xSemaphoreGive(s_ndef_out_lock);
+
+    nfc_event_t ev;
+    nfc_event_init(&ev, NFC_EVENT_NDEF_MESSAGE, tag);
+    nfc_events_post(&ev);
+}
+
+/* Polling side: queue the removal of the last notified tag, never blocks */
+static void post_tag_removed(void)
+{
+    nfc_event_t ev;
+    nfc_event_init(&ev, NFC_EVENT_TAG_REMOVED, NULL);
+    ev.uid_length = s_last_uid_length;
+    memcpy(ev.uid, s_last_uid, s_last_uid_length);
+    nfc_events_post(&ev);
+}
+
 void nfc_register_tag_detected_callback(void (*cb)(const pn532_tag_info_t *))
 {
     s_tag_detected_cb = cb;
@@ -91,73 +421,403 @@ void nfc_register_tag_removed_callback(void (*cb)(void))
     s_tag_removed_cb = cb;
 }
 
+/* Tag seen this cycle: debounce and notify (doc §12.2, §12.3) */
+static void handle_tag_found(const pn532_tag_info_t *tag)
+{
+    s_consecutive_misses = 0;
+    int64_t now = (int64_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    bool is_same_tag = compare_uid(tag->uid, tag->uid_length,
+                                   s_last_uid, s_last_uid_length);
+    bool debounce_expired = (now - s_last_detection_time_ms) > PN532_DEBOUNCE_MS;
+    bool should_notify = !is_same_tag || debounce_expired || !s_tag_was_present;
+
+    if (should_notify) {
+        memcpy(s_last_uid, tag->uid, tag->uid_length);
+        s_last_uid_length = tag->uid_length;
+        s_last_detection_time_ms = now;
+        s_tag_was_present = true;
+
+        nfc_event_t ev;
+        nfc_event_init(&ev, NFC_EVENT_TAG_DETECTED, tag);
+        nfc_events_post(&ev);
+
+        /* Only the RF read happens here; parsing and printing are the consumer's */
+        ndef_view_t msg;
+        if (load_tag_ndef(tag, &msg)) {
+            post_ndef_message(tag, msg);
+        }
+    }
+}
+
+/* No tag this cycle: count misses toward removal */
+static void handle_tag_missing(void)
+{
+    s_consecutive_misses++;
+    if (s_tag_was_present && s_consecutive_misses >= PN532_REMOVAL_THRESHOLD) {
+        s_tag_was_present = false;
+        post_tag_removed();
+#if !NFC_USE_AUTOPOLL
+        nfc_cadence_activity(&s_cadence, esp_timer_get_time());   /* The hold window starts here */
+#endif
+    }
+}
+
+#if PN532_STATS_ENABLE && (NFC_STATS_LOG_MS || NFC_BENCHMARK)
+static const char *const NFC_PHASE_NAMES[PN532_PHASE_COUNT] = { "write", "ack", "wait", "read" };
+
+/*
+ * Per command: exchanges, errors, mean time per phase, worst case and the
+ * latency histogram (bucket k < PN532_STATS_BUCKET0_US << k); then the
+ * exchange outcomes by pn532_err_t.
+ */
+static void nfc_print_stats(void)
+{
+    static pn532_stats_t st;   /* ~1.6 KB, kept off the task stack */
+    (void)pn532_get_stats(&s_pn532, &st);
+    for (unsigned k = 0; k < PN532_STATS_COMMANDS && st.commands[k].count; k++) {
+        const pn532_command_stats_t *c = &st.commands[k];
+        printf("STATS %02X: %lu x, %lu err, max %lu us, mean", c->command,
+               (unsigned long)c->count, (unsigned long)c->errors, (unsigned long)c->max_us);
+        for (unsigned p = 0; p < PN532_PHASE_COUNT; p++) {
+            printf(" %s %lu", NFC_PHASE_NAMES[p], (unsigned long)(c->phase_total_us[p] / c->count));
+        }
+        printf(" us, hist");
+        for (unsigned b = 0; b < PN532_STATS_BUCKETS; b++) {
+            printf(" %lu", (unsigned long)c->hist[b]);
+        }
+        printf("\n");
+    }
+    printf("STATS results:");
+    for (unsigned e = 0; e < PN532_ERR_COUNT; e++) {
+        if (st.results[e]) {
+            printf(" %u=%lu", e, (unsigned long)st.results[e]);
+        }
+    }
+    printf(", untracked %lu\n", (unsigned long)st.untracked);
+}
+#endif
+
+#if NFC_STATS_LOG_MS
+static void nfc_print_event_stats(void)
+{
+    nfc_events_stats_t es;
+    nfc_events_get_stats(&es);
+    printf("EVENTS posted %lu, delivered %lu, coalesced %lu, overflows %lu, high water %u/%d, "
+           "max wait %lu us, max handler %lu us, NDEF copies skipped %lu\n",
+           (unsigned long)es.posted, (unsigned long)es.delivered, (unsigned long)es.coalesced,
+           (unsigned long)es.overflows, es.high_water, NFC_EVENTS_QUEUE_LEN,
+           (unsigned long)es.max_wait_us, (unsigned long)es.max_handler_us,
+           (unsigned long)s_ndef_out_skipped);
+}
+
+/* Polling task: the STATS, EVENTS and STACK lines once *due_us has passed; true if printed */
+static bool nfc_log_stats_if_due(int64_t *due_us)
+{
+    if (esp_timer_get_time() < *due_us) {
+        return false;
+    }
+#if PN532_STATS_ENABLE
+    nfc_print_stats();
+#endif
+    nfc_print_event_stats();
+    printf("STACK nfc_poll %u of %d bytes never used\n",
+           (unsigned)uxTaskGetStackHighWaterMark(NULL), POLL_TASK_STACK);
+    *due_us += NFC_STATS_LOG_MS * 1000LL;
+    return true;
+}
+#endif
+
+/* RF settings from init (doc §6.9); a brown-out resets them to chip defaults */
+static pn532_err_t nfc_apply_rf_config(void)
+{
+    pn532_err_t err = pn532_set_max_retries(&s_pn532, PN532_RFCFG_RETRY_FOREVER, 0x01, NFC_PASSIVE_RETRIES);
+    if (err == PN532_OK) {
+        err = pn532_set_rf_timings(&s_pn532, 0x0B, NFC_NONDEP_TIMEOUT);
+    }
+    return err;
+}
+
+/* The reader answered: close the outage, if one needed recovery */
+static void nfc_comm_ok(void)
+{
+    if (s_config_stale) {
+        s_config_stale = false;
+        if (pn532_sam_config(&s_pn532) != PN532_OK || nfc_apply_rf_config() != PN532_OK) {
+            printf("NFC: Warning - configuration not restored\n");
+        }
+    }
+    if (s_comm_errors >= NFC_RECOVER_AFTER_ERRORS) {
+        int64_t us = esp_timer_get_time() - s_outage_start_us;
+        s_outages++;
+        s_outage_total_us += (uint64_t)us;
+        printf("NFC: reader back after %lu ms (mean time to recovery %lu ms over %lu outages)\n",
+               (unsigned long)(us / 1000), (unsigned long)(s_outage_total_us / s_outages / 1000),
+               (unsigned long)s_outages);
+    }
+    s_comm_errors = 0;
+}
+
+/*
+ * Count a communication error; from the NFC_RECOVER_AFTER_ERRORS'th in a row
+ * on, recover the bus and reader. Returns true to poll again at once, false
+ * when recovery failed and the caller should back off for a poll interval.
+ */
+static bool nfc_comm_error(pn532_err_t err)
+{
+    printf("NFC: Communication error %d\n", (int)err);
+    if (s_comm_errors++ == 0) {
+        s_outage_start_us = esp_timer_get_time();
+    }
+    if (s_comm_errors < NFC_RECOVER_AFTER_ERRORS) {
+        return true;
+    }
+    err = pn532_recover(&s_pn532);
+    if (err != PN532_OK) {
+        printf("NFC: reader recovery failed %d\n", (int)err);
+        s_config_stale = true;
+        return false;
+    }
+    if (nfc_apply_rf_config() != PN532_OK) {
+        printf("NFC: Warning - RF configuration not restored\n");
+    }
+    return true;
+}
+
+#if NFC_USE_AUTOPOLL
+/*
+ * Autopoll variant: the PN532 searches on its own. While idle the poll is
+ * endless and the task only wakes when a target shows up; while a tag is
+ * present a single short autopoll round serves as the removal probe.
+ */
 static void polling_task(void *arg)
 {
     (void)arg;
+    pn532_autopoll_config_t cfg = {
+        .period     = NFC_AUTOPOLL_PERIOD,
+        .type_count = 2,
+        .types      = { PN532_AUTOPOLL_TYPE_MIFARE, PN532_AUTOPOLL_TYPE_ISO14443_4A },
+    };
+#if NFC_STATS_LOG_MS
+    int64_t stats_due_us = esp_timer_get_time() + NFC_STATS_LOG_MS * 1000LL;
+#endif
+
     for (;;) {
+#if NFC_STATS_LOG_MS
+        (void)nfc_log_stats_if_due(&stats_due_us);
+#endif
+        cfg.poll_nr = s_tag_was_present ? 1 : PN532_AUTOPOLL_ENDLESS;
+        pn532_err_t err = pn532_start_autopoll(&s_pn532, &cfg);
+
         pn532_tag_info_t tag;
-        pn532_err_t err = pn532_read_passive_target(PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+        if (err == PN532_OK) {
+            uint32_t round_ms = (uint32_t)cfg.period * PN532_AUTOPOLL_PERIOD_UNIT_MS * cfg.type_count;
+            uint32_t wait_ms = (cfg.poll_nr == PN532_AUTOPOLL_ENDLESS)
+                               ? PN532_RESPONSE_TIMEOUT_MS : round_ms + PN532_RESPONSE_TIMEOUT_MS;
+            do {
+                err = pn532_autopoll_wait(&s_pn532, wait_ms, &tag);
+#if NFC_STATS_LOG_MS
+                (void)nfc_log_stats_if_due(&stats_due_us);
+#endif
+            } while (err == PN532_ERR_TIMEOUT && cfg.poll_nr == PN532_AUTOPOLL_ENDLESS);
+        }
 
         if (err == PN532_OK) {
-            s_consecutive_misses = 0;
-            int64_t now = (int64_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
-            bool is_same_tag = compare_uid(tag.uid, tag.uid_length,
-                                           s_last_uid, s_last_uid_length);
-            bool debounce_expired = (now - s_last_detection_time_ms) > PN532_DEBOUNCE_MS;
-            bool should_notify = !is_same_tag || debounce_expired || !s_tag_was_present;
-
-            if (should_notify) {
-                memcpy(s_last_uid, tag.uid, tag.uid_length);
-                s_last_uid_length = tag.uid_length;
-                s_last_detection_time_ms = now;
-                s_tag_was_present = true;
-                on_tag_detected(&tag);
+            handle_tag_found(&tag);
+            pn532_release_target(&s_pn532);
+            nfc_comm_ok();
+            vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+        } else if (err == PN532_ERR_NOT_FOUND || err == PN532_ERR_TIMEOUT) {
+            if (err == PN532_ERR_TIMEOUT) {
+                pn532_stop_autopoll(&s_pn532);
+            }
+            nfc_comm_ok();
+            handle_tag_missing();
+        } else if (!nfc_comm_error(err)) {
+            vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+        }
+    }
+}
+#else
+/*
+ * Sleep ms between polls and account the cycle (doc §12.6). User input
+ * (nfc_notify_user_activity) ends the sleep early and resets the cadence.
+ */
+static void nfc_idle(uint32_t ms, int64_t busy_start_us)
+{
+    int64_t start = esp_timer_get_time();
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) > 0) {
+        nfc_cadence_activity(&s_cadence, esp_timer_get_time());
+    }
+    nfc_cadence_account(&s_cadence, (uint32_t)(start - busy_start_us),
+                        (uint32_t)(esp_timer_get_time() - start));
+}
+
+/* Presence probe failed and re-detection found nothing: removal is confirmed */
+static void handle_tag_gone(void)
+{
+    s_consecutive_misses = 0;
+    if (s_tag_was_present) {
+        s_tag_was_present = false;
+        post_tag_removed();
+        nfc_cadence_activity(&s_cadence, esp_timer_get_time());   /* The hold window starts here */
+    }
+}
+
+/*
+ * List-based polling (doc §12.2). Tags that support a presence probe
+ * (doc §10.5) stay selected and only the probe runs until it fails; others
+ * are released and re-listed every cycle. With the field empty the scheduler
+ * picks the modulation (doc §12.4); while a tag is present, its own
+ * modulation is re-listed so a slot on another type never counts as a miss.
+ */
+static void polling_task(void *arg)
+{
+    (void)arg;
+    static const nfc_sched_config_t sched_cfg = {
+        .modes      = { PN532_BAUDRATE_106K_ISO14443A, PN532_BAUDRATE_106K_ISO14443B,
+                        PN532_BAUDRATE_212K_FELICA },
+        .mode_count = 3,
+        .max_gap    = NFC_SCHED_MAX_GAP,
+        .min_weight = NFC_SCHED_MIN_WEIGHT,
+        .rate_shift = NFC_SCHED_RATE_SHIFT,
+    };
+    nfc_sched_t sched;
+    nfc_sched_init(&sched, &sched_cfg);
+    pn532_tag_info_t tag;
+    bool selected = false;
+    uint8_t present_brty = PN532_BAUDRATE_106K_ISO14443A;
+    static const nfc_cadence_config_t cadence_cfg = {
+        .fast_ms  = NFC_CADENCE_FAST_MS,
+        .slow_ms  = NFC_CADENCE_SLOW_MS,
+        .hold_ms  = NFC_CADENCE_HOLD_MS,
+        .decay_ms = NFC_CADENCE_DECAY_MS,
+        .decay    = NFC_CADENCE_DECAY,
+    };
+    nfc_cadence_init(&s_cadence, &cadence_cfg, esp_timer_get_time());
+#if NFC_STATS_LOG_MS
+    int64_t stats_due_us = esp_timer_get_time() + NFC_STATS_LOG_MS * 1000LL;
+#endif
+
+    for (;;) {
+        bool probe_failed = false;
+        pn532_err_t err;
+        int64_t busy_start_us = esp_timer_get_time();
+
+#if NFC_STATS_LOG_MS
+        if (nfc_log_stats_if_due(&stats_due_us)) {
+            nfc_cadence_stats_t cs;
+            nfc_cadence_get_stats(&s_cadence, &cs);
+            unsigned duty = nfc_cadence_duty_permille(&s_cadence);
+            printf("CADENCE interval %lu ms, %lu polls, duty %u.%u%%\n", (unsigned long)cs.interval_ms,
+                   (unsigned long)cs.polls, duty / 10, duty % 10);
+        }
+#endif
+
+        if (selected) {
+            err = pn532_target_present(&s_pn532, &tag);
+            if (err == PN532_OK) {
+                nfc_comm_ok();
+                s_consecutive_misses = 0;
+                nfc_idle(NFC_PRESENCE_INTERVAL_MS, busy_start_us);
+                continue;
             }
+            /* Release and let a full detection confirm the removal */
+            selected = false;
+            probe_failed = true;
+            pn532_release_target(&s_pn532);
+        }
 
-            pn532_release_target();
+        unsigned slot = 0;
+        uint8_t brty = present_brty;
+        if (!s_tag_was_present) {
+            slot = nfc_sched_next(&sched);
+            brty = sched_cfg.modes[slot];
+        }
+        err = pn532_list_passive_target(&s_pn532, brty, PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+        if (!s_tag_was_present && (err == PN532_OK || err == PN532_ERR_NOT_FOUND ||
+                                   err == PN532_ERR_TIMEOUT)) {
+            nfc_sched_report(&sched, slot, err == PN532_OK);
+        }
+
+        if (err == PN532_OK) {
+            nfc_comm_ok();
+            present_brty = brty;
+            handle_tag_found(&tag);
+            selected = pn532_presence_check_supported(&tag);
+            if (!selected) {
+                pn532_release_target(&s_pn532);
+            }
         } else if (err == PN532_ERR_NOT_FOUND || err == PN532_ERR_TIMEOUT) {
-            s_consecutive_misses++;
-            if (s_tag_was_present && s_consecutive_misses >= PN532_REMOVAL_THRESHOLD) {
-                s_tag_was_present = false;
-                on_tag_removed();
+            nfc_comm_ok();
+            if (probe_failed) {
+                handle_tag_gone();
+            } else {
+                handle_tag_missing();
             }
+        } else if (nfc_comm_error(err)) {
+            continue;
         } else {
-            /* Communication error - log and continue */
-            printf("NFC: Communication error %d\n", (int)err);
+            /* Recovery failed: back off at the fixed interval, not the fast rate */
+            nfc_idle(PN532_POLL_INTERVAL_MS, busy_start_us);
+            continue;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+        /* A tag without a presence probe is re-listed at the probe interval until it leaves */
+        nfc_idle(s_tag_was_present ? NFC_PRESENCE_INTERVAL_MS
+                                   : nfc_cadence_interval_ms(&s_cadence, esp_timer_get_time()),
+                 busy_start_us);
     }
 }
+#endif
+
+/*
+ * User input (e.g. the encoder): a tap is likely soon, so poll at the fast
+ * rate again, starting now (doc §12.6). Task context; the AutoPoll variant
+ * ignores it.
+ */
+void nfc_notify_user_activity(void)
+{
+#if !NFC_USE_AUTOPOLL
+    if (s_poll_task) {
+        xTaskNotifyGive(s_poll_task);
+    }
+#endif
+}
 
 void nfc_start_scanning(void)
 {
-    xTaskCreate(polling_task, "nfc_poll", POLL_TASK_STACK, NULL, POLL_TASK_PRIO, NULL);
+    s_ndef_out_lock = xSemaphoreCreateMutexStatic(&s_ndef_out_lock_buf);
+    if (!nfc_events_start(nfc_dispatch, NULL)) {
+        printf("NFC: event dispatcher not started\n");
+        return;
+    }
+    xTaskCreate(polling_task, "nfc_poll", POLL_TASK_STACK, NULL, POLL_TASK_PRIO, &s_poll_task);
 }
 
 /* Full init (doc §9.1) */
 static pn532_err_t nfc_init(void)
 {
-    pn532_err_t err = pn532_init();
+    pn532_config_t config = PN532_CONFIG_DEFAULT();
+    pn532_err_t err = pn532_init(&s_pn532, &config);
     if (err != PN532_OK) {
-        printf("NFC: I2C init failed %d\n", (int)err);
+        printf("NFC: bus init failed %d\n", (int)err);
         return err;
     }
 
-    pn532_wakeup();
+    pn532_wakeup(&s_pn532);
     vTaskDelay(pdMS_TO_TICKS(PN532_POST_WAKEUP_MS));
     vTaskDelay(pdMS_TO_TICKS(PN532_POST_INIT_MS));
 
     pn532_firmware_version_t fw;
     int retries = 3;
     do {
-        err = pn532_get_firmware_version(&fw);
+        err = pn532_get_firmware_version(&s_pn532, &fw);
         if (err == PN532_OK) {
             break;
         }
         retries--;
         if (retries > 0) {
-            pn532_wakeup();
+            pn532_wakeup(&s_pn532);
             vTaskDelay(pdMS_TO_TICKS(PN532_RETRY_DELAY_MS));
         }
     } while (retries > 0);
@@ -171,15 +831,212 @@ static pn532_err_t nfc_init(void)
         printf("NFC: Warning - unexpected IC 0x%02X (expected 0x32)\n", fw.ic);
     }
 
-    err = pn532_sam_config();
+    err = pn532_sam_config(&s_pn532);
     if (err != PN532_OK) {
         printf("NFC: SAM config failed %d\n", (int)err);
         return err;
     }
 
+    err = nfc_apply_rf_config();
+    if (err != PN532_OK) {
+        /* Still usable: empty-field polls just fall back to the host timeout */
+        printf("NFC: Warning - RF configuration failed %d\n", (int)err);
+    }
+
+    /* HSU starts at 115200 (doc §6.8); not fatal if the board can't go faster */
+    if (s_pn532.config.transport == PN532_TRANSPORT_HSU) {
+        err = pn532_set_serial_baud_rate(&s_pn532, s_pn532.config.uart.baud);
+        if (err != PN532_OK && s_pn532.config.uart.baud > 460800) {
+            err = pn532_set_serial_baud_rate(&s_pn532, 460800);
+        }
+        if (err != PN532_OK) {
+            printf("NFC: Warning - HSU stays at %lu baud (%d)\n",
+                   (unsigned long)s_pn532.bus_baud, (int)err);
+        }
+    }
+
     return PN532_OK;
 }
 
+#if NFC_BENCHMARK
+static const char *transport_str(pn532_transport_t t)
+{
+    switch (t) {
+        case PN532_TRANSPORT_SPI: return "SPI";
+        case PN532_TRANSPORT_HSU: return "HSU";
+        default:                  return "I2C";
+    }
+}
+
+/*
+ * Command round trip (GetFirmwareVersion) and, with an NTAG on the reader,
+ * FAST_READ throughput. Bus time comes from the transport counters.
+ */
+static void nfc_benchmark(void)
+{
+    pn532_firmware_version_t fw;
+    pn532_transport_stats_t st;
+
+    pn532_reset_transport_stats(&s_pn532);
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < NFC_BENCH_ROUNDS; i++) {
+        if (pn532_get_firmware_version(&s_pn532, &fw) != PN532_OK) {
+            printf("BENCH: GetFirmwareVersion failed\n");
+            return;
+        }
+    }
+    int64_t cmd_us = (esp_timer_get_time() - t0) / NFC_BENCH_ROUNDS;
+    pn532_get_transport_stats(&s_pn532, &st);
+    printf("BENCH %s %lu: cmd %lld us, bus %lu us/txn\n",
+           transport_str(s_pn532.config.transport), (unsigned long)s_pn532.bus_baud,
+           (long long)cmd_us, (unsigned long)(st.total_us / (st.transactions ? st.transactions : 1)));
+
+    pn532_tag_info_t tag;
+    if (pn532_read_passive_target(&s_pn532, PN532_RESPONSE_TIMEOUT_MS, &tag) != PN532_OK ||
+        tag.type != PN532_TAG_NTAG) {
+        printf("BENCH: no NTAG on the reader, skipping read test\n");
+        return;
+    }
+    size_t bytes = (NFC_BENCH_LAST_PAGE - 4 + 1) * PN532_NTAG_PAGE_SIZE;
+    pn532_reset_transport_stats(&s_pn532);
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < NFC_BENCH_ROUNDS; i++) {
+        if (pn532_ntag_fast_read(&s_pn532, tag.tg, 4, NFC_BENCH_LAST_PAGE,
+                                 s_ndef_buf, sizeof(s_ndef_buf)) != PN532_OK) {
+            printf("BENCH: FAST_READ failed\n");
+            pn532_release_target(&s_pn532);
+            return;
+        }
+    }
+    int64_t read_us = esp_timer_get_time() - t0;
+    pn532_get_transport_stats(&s_pn532, &st);
+    printf("BENCH %s: FAST_READ %u B in %lld us, %lu B/s, bus share %lu%%\n",
+           transport_str(s_pn532.config.transport), (unsigned)bytes,
+           (long long)(read_us / NFC_BENCH_ROUNDS),
+           (unsigned long)(bytes * NFC_BENCH_ROUNDS * 1000000LL / read_us),
+           (unsigned long)(st.total_us * 100 / read_us));
+    pn532_release_target(&s_pn532);
+#if PN532_STATS_ENABLE
+    nfc_print_stats();
+#endif
+}
+#endif
+
+#if NFC_PROVISION
+static int hex_nibble(int c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/*
+ * One line of hex from the console into out, whitespace ignored. The console
+ * VFS is non-blocking, so EOF only means "nothing yet". Returns the byte
+ * count, or 0 for an empty, odd-length, invalid or oversized line.
+ */
+static size_t read_console_hex(uint8_t *out, size_t out_max)
+{
+    size_t n = 0;
+    int hi = -1;
+    bool bad = false;
+    for (;;) {
+        int c = getchar();
+        if (c == EOF) {
+            clearerr(stdin);
+            vTaskDelay(pdMS_TO_TICKS(NFC_CONSOLE_IDLE_MS));
+            continue;
+        }
+        if (c == '\n' || c == '\r') {
+            if (n > 0 || hi >= 0 || bad) {
+                return (bad || hi >= 0) ? 0 : n;
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\t') {
+            continue;
+        }
+        int v = hex_nibble(c);
+        if (v < 0 || n >= out_max) {
+            bad = true;
+        } else if (hi < 0) {
+            hi = v;
+        } else {
+            out[n++] = (uint8_t)(hi << 4 | v);
+            hi = -1;
+        }
+    }
+}
+
+/*
+ * Provisioning loop (doc §10.7): every NTAG that arrives gets the image
+ * written from page 4 and verified. A tag left on the reader is written
+ * once; the next tag (or the same one put back) is written again.
+ */
+static void nfc_provision(void)
+{
+    size_t msg_len;
+    size_t tlv_len = 0;
+    do {
+        printf("PROV: send the NDEF message as one hex line\n");
+        msg_len = read_console_hex(s_ndef_buf, NFC_TYPE2_DATA_MAX);
+    } while (msg_len == 0 ||
+             ndef_build_tlv(s_ndef_buf, msg_len, s_ndef_buf, NFC_TYPE2_DATA_MAX, &tlv_len) != NDEF_OK);
+
+    unsigned pages = (unsigned)((tlv_len + PN532_NTAG_PAGE_SIZE - 1) / PN532_NTAG_PAGE_SIZE);
+    memset(s_ndef_buf + tlv_len, 0, pages * PN532_NTAG_PAGE_SIZE - tlv_len);
+    printf("PROV: image %u bytes, %u pages. Present tags.\n", (unsigned)msg_len, pages);
+
+    for (;;) {
+        pn532_tag_info_t tag;
+        pn532_err_t err = pn532_read_passive_target(&s_pn532, PN532_TAG_DETECT_TIMEOUT_MS, &tag);
+        if (err != PN532_OK) {
+            s_last_uid_length = 0;
+            vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+            continue;
+        }
+        if (compare_uid(tag.uid, tag.uid_length, s_last_uid, s_last_uid_length)) {
+            pn532_release_target(&s_pn532);
+            vTaskDelay(pdMS_TO_TICKS(PN532_POLL_INTERVAL_MS));
+            continue;
+        }
+        memcpy(s_last_uid, tag.uid, tag.uid_length);
+        s_last_uid_length = tag.uid_length;
+
+        printf("PROV ");
+        for (int i = 0; i < tag.uid_length; i++) {
+            printf("%02X", tag.uid[i]);
+        }
+
+        uint8_t cc_page[PN532_NTAG_READ_LEN];
+        ndef_cc_t cc;
+        pn532_ntag_write_result_t res;
+        if (tag.type != PN532_TAG_NTAG && tag.type != PN532_TAG_MIFARE_ULTRALIGHT) {
+            printf(": not a Type 2 tag\n");
+        } else if (pn532_ntag_read(&s_pn532, tag.tg, 3, cc_page) != PN532_OK ||
+                   ndef_parse_cc(cc_page, &cc) != NDEF_OK) {
+            printf(": no NDEF capability container\n");
+        } else if ((cc.access & 0x0F) != 0x00 || cc.data_area_size < pages * PN532_NTAG_PAGE_SIZE) {
+            printf(": read-only or too small (%u bytes)\n", (unsigned)cc.data_area_size);
+        } else {
+            err = pn532_ntag_write_pages(&s_pn532, tag.tg, 4, s_ndef_buf, pages,
+                                         NFC_PROVISION_VERIFY, &res);
+            printf(": %u/%u pages, write %lu us, verify %lu us, %lu pages/s %s\n",
+                   res.pages, pages, (unsigned long)res.write_us, (unsigned long)res.verify_us,
+                   (unsigned long)res.pages_per_s, (err == PN532_OK) ? "OK" : "FAIL");
+        }
+        pn532_release_target(&s_pn532);
+    }
+}
+#endif
+
 void app_main(void)
 {
     printf("NFC: Initializing PN532...\n");
@@ -190,6 +1047,12 @@ void app_main(void)
         return;
     }
 
+#if NFC_BENCHMARK
+    nfc_benchmark();
+#elif NFC_PROVISION
+    nfc_provision();
+#else
     printf("NFC: Init OK. Starting polling.\n");
     nfc_start_scanning();
+#endif
 }
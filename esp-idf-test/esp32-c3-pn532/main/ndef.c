@@ -0,0 +1,170 @@
+/**
+ * NDEF parser implementation.
+ * See TECHNICAL_DOCUMENTATION.md §10.4.
+ */
+
+#include "ndef.h"
+#include <string.h>
+
+ndef_err_t ndef_parse_cc(const uint8_t cc[NDEF_CC_LEN], ndef_cc_t *out)
+{
+    if (!cc || !out || cc[0] != NDEF_CC_MAGIC) {
+        return NDEF_ERR_FORMAT;
+    }
+    /* Only major version 1 is defined for Type 2 tags */
+    if ((cc[1] >> 4) != 0x1) {
+        return NDEF_ERR_FORMAT;
+    }
+    out->version = cc[1];
+    out->data_area_size = (uint16_t)(cc[2] * 8);
+    out->access = cc[3];
+    return NDEF_OK;
+}
+
+ndef_err_t ndef_find_message(const uint8_t *buf, size_t len, ndef_view_t *msg, size_t *needed)
+{
+    if (!buf || !msg || !needed) {
+        return NDEF_ERR_FORMAT;
+    }
+
+    size_t off = 0;
+    for (;;) {
+        if (off >= len) {
+            *needed = off + 1;
+            return NDEF_ERR_INCOMPLETE;
+        }
+
+        uint8_t t = buf[off];
+        if (t == NDEF_TLV_NULL) {
+            off++;
+            continue;
+        }
+        if (t == NDEF_TLV_TERMINATOR) {
+            return NDEF_ERR_NOT_FOUND;
+        }
+
+        /* Length: 1 byte, or 0xFF followed by a 2-byte big-endian length */
+        if (off + 2 > len) {
+            *needed = off + 2;
+            return NDEF_ERR_INCOMPLETE;
+        }
+        size_t value_off;
+        size_t value_len;
+        if (buf[off + 1] == 0xFF) {
+            if (off + 4 > len) {
+                *needed = off + 4;
+                return NDEF_ERR_INCOMPLETE;
+            }
+            value_len = ((size_t)buf[off + 2] << 8) | buf[off + 3];
+            value_off = off + 4;
+        } else {
+            value_len = buf[off + 1];
+            value_off = off + 2;
+        }
+
+        if (t == NDEF_TLV_MESSAGE) {
+            *needed = value_off + value_len;
+            if (*needed > len) {
+                return NDEF_ERR_INCOMPLETE;
+            }
+            msg->ptr = buf + value_off;
+            msg->len = value_len;
+            return NDEF_OK;
+        }
+
+        /* Lock/memory control and proprietary TLVs are skipped */
+        off = value_off + value_len;
+    }
+}
+
+ndef_err_t ndef_build_tlv(const uint8_t *msg, size_t msg_len, uint8_t *out, size_t out_max,
+                          size_t *out_len)
+{
+    if ((!msg && msg_len > 0) || !out || !out_len || msg_len > 0xFFFE) {
+        return NDEF_ERR_FORMAT;
+    }
+    size_t hdr = (msg_len < 0xFF) ? 2 : 4;
+    if (hdr + msg_len + 1 > out_max) {
+        return NDEF_ERR_FORMAT;
+    }
+
+    if (msg_len > 0) {
+        memmove(out + hdr, msg, msg_len);
+    }
+    out[0] = NDEF_TLV_MESSAGE;
+    if (hdr == 2) {
+        out[1] = (uint8_t)msg_len;
+    } else {
+        out[1] = 0xFF;
+        out[2] = (uint8_t)(msg_len >> 8);
+        out[3] = (uint8_t)msg_len;
+    }
+    out[hdr + msg_len] = NDEF_TLV_TERMINATOR;
+    *out_len = hdr + msg_len + 1;
+    return NDEF_OK;
+}
+
+void ndef_reader_init(ndef_reader_t *reader, ndef_view_t msg)
+{
+    reader->pos = msg.ptr;
+    reader->end = msg.ptr + msg.len;
+    reader->done = (msg.len == 0);
+}
+
+ndef_err_t ndef_next_record(ndef_reader_t *reader, ndef_record_t *rec)
+{
+    if (!reader || !rec) {
+        return NDEF_ERR_FORMAT;
+    }
+    if (reader->done || reader->pos >= reader->end) {
+        return NDEF_ERR_END;
+    }
+
+    const uint8_t *p = reader->pos;
+    size_t avail = (size_t)(reader->end - p);
+
+    /* Header, TYPE_LENGTH, then 1 (SR) or 4 payload length bytes, then optional ID_LENGTH */
+    uint8_t header = p[0];
+    size_t need = 2 + ((header & NDEF_FLAG_SR) ? 1 : 4) + ((header & NDEF_FLAG_IL) ? 1 : 0);
+    if (avail < need) {
+        return NDEF_ERR_FORMAT;
+    }
+
+    size_t i = 1;
+    size_t type_len = p[i++];
+    size_t payload_len;
+    if (header & NDEF_FLAG_SR) {
+        payload_len = p[i++];
+    } else {
+        uint32_t pl = ((uint32_t)p[i] << 24) | ((uint32_t)p[i + 1] << 16) |
+                      ((uint32_t)p[i + 2] << 8) | p[i + 3];
+        i += 4;
+        payload_len = pl;
+    }
+    size_t id_len = (header & NDEF_FLAG_IL) ? p[i++] : 0;
+
+    /* Compare against what is left, never add lengths that could wrap */
+    size_t left = avail - i;
+    if (type_len > left || id_len > left - type_len ||
+        payload_len > left - type_len - id_len) {
+        return NDEF_ERR_FORMAT;
+    }
+
+    rec->header = header;
+    rec->tnf = (ndef_tnf_t)(header & NDEF_TNF_MASK);
+    rec->type.ptr = p + i;
+    rec->type.len = type_len;
+    i += type_len;
+    rec->id.ptr = p + i;
+    rec->id.len = id_len;
+    i += id_len;
+    rec->payload.ptr = p + i;
+    rec->payload.len = payload_len;
+    i += payload_len;
+
+    reader->pos = p + i;
+    if (header & NDEF_FLAG_ME) {
+        reader->done = true;
+    }
+    return NDEF_OK;
+}
@@ -0,0 +1,123 @@
+/**
+ * NDEF parser for NFC Forum tags (doc §10.4). The Capability Container
+ * applies to Type 2 tags (NTAG / Ultralight); the TLV scan to Type 2 memory
+ * and the data blocks of MIFARE Classic NDEF sectors; the record parser to
+ * any message, including a Type 4 NDEF file read without its NLEN.
+ * No allocation and no copies: results are views into the caller's buffer.
+ * Pure C with no ESP-IDF dependencies, so it also builds on the host.
+ */
+
+#ifndef NDEF_H
+#define NDEF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* --- Capability Container (page 3) --- */
+#define NDEF_CC_MAGIC           0xE1
+#define NDEF_CC_LEN             4
+
+/* --- TLV types --- */
+#define NDEF_TLV_NULL           0x00
+#define NDEF_TLV_LOCK_CONTROL   0x01
+#define NDEF_TLV_MEMORY_CONTROL 0x02
+#define NDEF_TLV_MESSAGE        0x03
+#define NDEF_TLV_PROPRIETARY    0xFD
+#define NDEF_TLV_TERMINATOR     0xFE
+
+/* --- Record header flags and TNF --- */
+#define NDEF_FLAG_MB            0x80
+#define NDEF_FLAG_ME            0x40
+#define NDEF_FLAG_CF            0x20
+#define NDEF_FLAG_SR            0x10
+#define NDEF_FLAG_IL            0x08
+#define NDEF_TNF_MASK           0x07
+
+typedef enum {
+    NDEF_TNF_EMPTY        = 0x00,
+    NDEF_TNF_WELL_KNOWN   = 0x01,
+    NDEF_TNF_MIME_MEDIA   = 0x02,
+    NDEF_TNF_ABSOLUTE_URI = 0x03,
+    NDEF_TNF_EXTERNAL     = 0x04,
+    NDEF_TNF_UNKNOWN      = 0x05,
+    NDEF_TNF_UNCHANGED    = 0x06,
+} ndef_tnf_t;
+
+/* --- Return codes --- */
+typedef enum {
+    NDEF_OK = 0,
+    NDEF_ERR_INCOMPLETE,   /* More bytes needed; see *needed */
+    NDEF_ERR_NOT_FOUND,    /* No NDEF message TLV before the terminator */
+    NDEF_ERR_FORMAT,       /* Malformed CC, TLV or record */
+    NDEF_ERR_END,          /* No more records in the message */
+} ndef_err_t;
+
+/* Pointer + length into the raw tag buffer */
+typedef struct {
+    const uint8_t *ptr;
+    size_t len;
+} ndef_view_t;
+
+typedef struct {
+    uint8_t version;          /* Major in high nibble, minor in low nibble */
+    uint16_t data_area_size;  /* Bytes of user memory after the CC (CC[2] * 8) */
+    uint8_t access;           /* Read access high nibble, write access low nibble */
+} ndef_cc_t;
+
+typedef struct {
+    uint8_t header;           /* MB/ME/CF/SR/IL flags and TNF */
+    ndef_tnf_t tnf;
+    ndef_view_t type;
+    ndef_view_t id;
+    ndef_view_t payload;
+} ndef_record_t;
+
+typedef struct {
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool done;
+} ndef_reader_t;
+
+/**
+ * Parse the 4-byte Capability Container of a Type 2 tag.
+ */
+ndef_err_t ndef_parse_cc(const uint8_t cc[NDEF_CC_LEN], ndef_cc_t *out);
+
+/**
+ * Find the NDEF message TLV in the data area (buf starts at page 4).
+ * buf may hold only the first part of the data area: when the TLV header or
+ * value runs past len, returns NDEF_ERR_INCOMPLETE and *needed is the number
+ * of data-area bytes required, so the reader can fetch exactly that much and
+ * call again. On NDEF_OK, *msg points at the message and *needed is the end
+ * offset of its TLV.
+ */
+ndef_err_t ndef_find_message(const uint8_t *buf, size_t len, ndef_view_t *msg, size_t *needed);
+
+/**
+ * Wrap an NDEF message for writing to the data area: message TLV (1- or
+ * 3-byte length) followed by the terminator TLV. msg may already sit anywhere
+ * inside out; it is moved into place. NDEF_ERR_FORMAT if out_max is too small.
+ */
+ndef_err_t ndef_build_tlv(const uint8_t *msg, size_t msg_len, uint8_t *out, size_t out_max,
+                          size_t *out_len);
+
+/**
+ * Start iterating the records of an NDEF message.
+ */
+void ndef_reader_init(ndef_reader_t *reader, ndef_view_t msg);
+
+/**
+ * Return the next record. NDEF_ERR_END after the ME record or end of message.
+ */
+ndef_err_t ndef_next_record(ndef_reader_t *reader, ndef_record_t *rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NDEF_H */
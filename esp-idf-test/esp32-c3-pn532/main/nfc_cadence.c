@@ -0,0 +1,95 @@
+/**
+ * Adaptive polling cadence implementation.
+ * See TECHNICAL_DOCUMENTATION.md §12.6.
+ */
+
+#include "nfc_cadence.h"
+#include <string.h>
+
+void nfc_cadence_init(nfc_cadence_t *c, const nfc_cadence_config_t *cfg, int64_t now_us)
+{
+    memset(c, 0, sizeof(*c));
+    c->cfg = *cfg;
+    if (c->cfg.fast_ms == 0) {
+        c->cfg.fast_ms = 1;
+    }
+    if (c->cfg.slow_ms < c->cfg.fast_ms) {
+        c->cfg.slow_ms = c->cfg.fast_ms;
+    }
+    if (c->cfg.decay_ms == 0) {
+        c->cfg.decay_ms = 1;
+    }
+    c->last_activity_us = now_us;
+    c->stats.interval_ms = c->cfg.fast_ms;
+}
+
+void nfc_cadence_activity(nfc_cadence_t *c, int64_t now_us)
+{
+    c->last_activity_us = now_us;
+    c->stats.activities++;
+}
+
+/*
+ * Exponential: the interval doubles every decay_ms and is interpolated
+ * linearly within each doubling, so it rises smoothly instead of in steps.
+ */
+uint32_t nfc_cadence_interval_ms(nfc_cadence_t *c, int64_t now_us)
+{
+    const nfc_cadence_config_t *cfg = &c->cfg;
+    int64_t quiet_ms = (now_us - c->last_activity_us) / 1000;
+    uint64_t iv = cfg->fast_ms;
+
+    if (quiet_ms >= (int64_t)cfg->hold_ms) {
+        uint64_t t = (uint64_t)(quiet_ms - cfg->hold_ms);
+        switch (cfg->decay) {
+            case NFC_CADENCE_DECAY_LINEAR:
+                iv = (t >= cfg->decay_ms) ? cfg->slow_ms
+                     : cfg->fast_ms + (uint64_t)(cfg->slow_ms - cfg->fast_ms) * t / cfg->decay_ms;
+                break;
+            case NFC_CADENCE_DECAY_EXPONENTIAL: {
+                uint64_t doublings = t / cfg->decay_ms;
+                if (doublings >= 32) {
+                    iv = cfg->slow_ms;
+                } else {
+                    iv = (uint64_t)cfg->fast_ms << doublings;
+                    iv += iv * (t % cfg->decay_ms) / cfg->decay_ms;
+                }
+                break;
+            }
+            default:
+                iv = cfg->slow_ms;
+                break;
+        }
+    }
+    if (iv > cfg->slow_ms) {
+        iv = cfg->slow_ms;
+    }
+    c->stats.interval_ms = (uint32_t)iv;
+    return (uint32_t)iv;
+}
+
+void nfc_cadence_account(nfc_cadence_t *c, uint32_t busy_us, uint32_t idle_us)
+{
+    c->stats.polls++;
+    c->stats.busy_us += busy_us;
+    c->stats.idle_us += idle_us;
+}
+
+unsigned nfc_cadence_duty_permille(const nfc_cadence_t *c)
+{
+    uint64_t total = c->stats.busy_us + c->stats.idle_us;
+    return total ? (unsigned)(c->stats.busy_us * 1000 / total) : 0;
+}
+
+void nfc_cadence_get_stats(const nfc_cadence_t *c, nfc_cadence_stats_t *stats)
+{
+    if (stats) {
+        *stats = c->stats;
+    }
+}
+
+void nfc_cadence_reset_stats(nfc_cadence_t *c)
+{
+    uint32_t interval_ms = c->stats.interval_ms;
+    c->stats = (nfc_cadence_stats_t){ .interval_ms = interval_ms };
+}
@@ -0,0 +1,81 @@
+/**
+ * Adaptive polling cadence: how long to sleep before the next empty-field
+ * poll. Right after activity (tag seen or removed, user input) the reader
+ * polls fast, since the next tap is likely; the longer nothing happens, the
+ * closer the interval gets to a slow idle rate. Also accounts busy versus
+ * idle time for the duty cycle. The caller passes the time in, so this is
+ * pure C with no ESP-IDF dependencies and also builds on the host.
+ */
+
+#ifndef NFC_CADENCE_H
+#define NFC_CADENCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    NFC_CADENCE_DECAY_STEP,          /* fast_ms for hold_ms, then slow_ms */
+    NFC_CADENCE_DECAY_LINEAR,        /* fast_ms to slow_ms over decay_ms */
+    NFC_CADENCE_DECAY_EXPONENTIAL,   /* Interval doubles every decay_ms, up to slow_ms */
+} nfc_cadence_decay_t;
+
+typedef struct {
+    uint32_t fast_ms;                /* Interval right after activity */
+    uint32_t slow_ms;                /* Idle interval the decay ends at; >= fast_ms */
+    uint32_t hold_ms;                /* Time at fast_ms before the decay starts */
+    uint32_t decay_ms;               /* Curve time constant, see nfc_cadence_decay_t */
+    nfc_cadence_decay_t decay;
+} nfc_cadence_config_t;
+
+typedef struct {
+    uint32_t polls;                  /* nfc_cadence_account() calls */
+    uint32_t activities;
+    uint64_t busy_us;                /* Reader working: polls, probes, tag reads */
+    uint64_t idle_us;                /* Sleeping between polls */
+    uint32_t interval_ms;            /* Last interval handed out */
+} nfc_cadence_stats_t;
+
+typedef struct {
+    nfc_cadence_config_t cfg;
+    int64_t last_activity_us;
+    nfc_cadence_stats_t stats;
+} nfc_cadence_t;
+
+/**
+ * Reset c to cfg; start-up counts as activity, so polling begins fast.
+ * slow_ms is raised to fast_ms if below it, and fast_ms and decay_ms to 1 if 0.
+ */
+void nfc_cadence_init(nfc_cadence_t *c, const nfc_cadence_config_t *cfg, int64_t now_us);
+
+/**
+ * Something happened: go back to fast_ms and restart the hold window.
+ */
+void nfc_cadence_activity(nfc_cadence_t *c, int64_t now_us);
+
+/**
+ * Sleep before the next empty-field poll, per the decay curve.
+ */
+uint32_t nfc_cadence_interval_ms(nfc_cadence_t *c, int64_t now_us);
+
+/**
+ * Add one poll cycle: busy_us working, then idle_us asleep.
+ */
+void nfc_cadence_account(nfc_cadence_t *c, uint32_t busy_us, uint32_t idle_us);
+
+/**
+ * Average duty cycle since init or reset, in 1/1000 of the time the reader was busy.
+ */
+unsigned nfc_cadence_duty_permille(const nfc_cadence_t *c);
+
+void nfc_cadence_get_stats(const nfc_cadence_t *c, nfc_cadence_stats_t *stats);
+void nfc_cadence_reset_stats(nfc_cadence_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NFC_CADENCE_H */
@@ -0,0 +1,175 @@
+/**
+ * Tag event dispatcher (doc §12.5).
+ * A ring of NFC_EVENTS_QUEUE_LEN events under a mutex, plus a counting
+ * semaphore holding the number pending. A FreeRTOS queue would do for plain
+ * FIFO, but coalescing and drop-oldest need to look at and rewrite pending
+ * entries. The mutex is only held to copy 32 bytes, never across a handler.
+ */
+
+#include "nfc_events.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "nfc_events";
+
+static nfc_event_t s_ring[NFC_EVENTS_QUEUE_LEN];
+static unsigned s_head;              /* Oldest pending */
+static unsigned s_count;
+static nfc_events_stats_t s_stats;
+
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+static SemaphoreHandle_t s_pending;  /* Counts s_count for the consumers */
+static StaticSemaphore_t s_pending_buf;
+
+static nfc_event_handler_t s_handler;
+static void *s_ctx;
+
+static nfc_event_t *slot(unsigned i)
+{
+    return &s_ring[(s_head + i) % NFC_EVENTS_QUEUE_LEN];
+}
+
+static bool same_uid(const nfc_event_t *a, const nfc_event_t *b)
+{
+    return a->uid_length == b->uid_length && memcmp(a->uid, b->uid, a->uid_length) == 0;
+}
+
+bool nfc_events_dispatch(TickType_t wait)
+{
+    if (xSemaphoreTake(s_pending, wait) != pdTRUE) {
+        return false;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    nfc_event_t ev = *slot(0);
+    s_head = (s_head + 1) % NFC_EVENTS_QUEUE_LEN;
+    s_count--;
+    xSemaphoreGive(s_lock);
+
+    int64_t start = esp_timer_get_time();
+    s_handler(&ev, s_ctx);
+    int64_t end = esp_timer_get_time();
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.delivered++;
+    if ((uint32_t)(start - ev.timestamp_us) > s_stats.max_wait_us) {
+        s_stats.max_wait_us = (uint32_t)(start - ev.timestamp_us);
+    }
+    if ((uint32_t)(end - start) > s_stats.max_handler_us) {
+        s_stats.max_handler_us = (uint32_t)(end - start);
+    }
+    xSemaphoreGive(s_lock);
+    return true;
+}
+
+static void consumer_task(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        (void)nfc_events_dispatch(portMAX_DELAY);
+    }
+}
+
+bool nfc_events_start(nfc_event_handler_t handler, void *ctx)
+{
+    s_handler = handler;
+    s_ctx = ctx;
+    s_head = 0;
+    s_count = 0;
+    s_stats = (nfc_events_stats_t){ 0 };
+    s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+    s_pending = xSemaphoreCreateCountingStatic(NFC_EVENTS_QUEUE_LEN, 0, &s_pending_buf);
+
+    for (int i = 0; i < NFC_EVENTS_CONSUMERS; i++) {
+        if (xTaskCreate(consumer_task, "nfc_events", NFC_EVENTS_TASK_STACK, NULL,
+                        NFC_EVENTS_TASK_PRIO, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "consumer task %d not created", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void nfc_event_init(nfc_event_t *ev, nfc_event_kind_t kind, const pn532_tag_info_t *tag)
+{
+    *ev = (nfc_event_t){ .kind = (uint8_t)kind, .timestamp_us = esp_timer_get_time() };
+    if (tag) {
+        ev->type = (uint8_t)tag->type;
+        ev->uid_length = tag->uid_length;
+        memcpy(ev->uid, tag->uid, tag->uid_length);
+        ev->sak = tag->sak;
+        memcpy(ev->atqa, tag->atqa, sizeof(ev->atqa));
+        ev->brty = tag->brty;
+    }
+}
+
+void nfc_events_post(const nfc_event_t *ev)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.posted++;
+
+    /* Only the newest pending event for this UID may absorb it, so order is kept */
+    for (unsigned i = s_count; i-- > 0;) {
+        nfc_event_t *p = slot(i);
+        if (!same_uid(p, ev)) {
+            continue;
+        }
+        if (p->kind == ev->kind) {
+            if (p->repeats < UINT16_MAX) {
+                p->repeats++;
+            }
+            s_stats.coalesced++;
+            xSemaphoreGive(s_lock);
+            return;
+        }
+        break;
+    }
+
+    bool full = (s_count == NFC_EVENTS_QUEUE_LEN);
+    if (full) {
+        s_head = (s_head + 1) % NFC_EVENTS_QUEUE_LEN;
+        s_count--;
+        s_stats.overflows++;
+    }
+    *slot(s_count) = *ev;
+    s_count++;
+    if (s_count > s_stats.high_water) {
+        s_stats.high_water = s_count;
+    }
+    xSemaphoreGive(s_lock);
+
+    /* A dropped event's count is reused by its replacement */
+    if (!full) {
+        xSemaphoreGive(s_pending);
+    }
+}
+
+void nfc_event_to_tag_info(const nfc_event_t *ev, pn532_tag_info_t *tag)
+{
+    *tag = (pn532_tag_info_t){
+        .uid_length = ev->uid_length,
+        .sak        = ev->sak,
+        .atqa       = { ev->atqa[0], ev->atqa[1] },
+        .type       = (pn532_tag_type_t)ev->type,
+        .brty       = ev->brty,
+    };
+    memcpy(tag->uid, ev->uid, ev->uid_length);
+}
+
+void nfc_events_get_stats(nfc_events_stats_t *stats)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
+
+void nfc_events_reset_stats(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats = (nfc_events_stats_t){ 0 };
+    xSemaphoreGive(s_lock);
+}
@@ -0,0 +1,94 @@
+/**
+ * Tag event dispatcher (doc §12.5). The polling task posts compact events
+ * and never blocks; consumer tasks run the handler, so a slow callback
+ * (audio start-up, display redraw, flash lookup) cannot delay the next poll
+ * or removal detection. Fixed-size ring, no heap besides the consumer tasks.
+ */
+
+#ifndef NFC_EVENTS_H
+#define NFC_EVENTS_H
+
+#include "pn532.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NFC_EVENTS_QUEUE_LEN   8
+/*
+ * More than one only if the handler copes with events running concurrently
+ * and out of order; 0 if the application calls nfc_events_dispatch() itself.
+ */
+#define NFC_EVENTS_CONSUMERS   1
+#define NFC_EVENTS_TASK_STACK  4096
+#define NFC_EVENTS_TASK_PRIO   4     /* Below the polling task */
+
+typedef enum {
+    NFC_EVENT_TAG_DETECTED,
+    NFC_EVENT_TAG_REMOVED,
+    NFC_EVENT_NDEF_MESSAGE,          /* NDEF read from the tag; the message travels separately */
+} nfc_event_kind_t;
+
+/* 32 bytes; everything the callbacks need without talking to the tag again */
+typedef struct {
+    uint8_t kind;                    /* nfc_event_kind_t */
+    uint8_t type;                    /* pn532_tag_type_t; detected only */
+    uint8_t uid_length;
+    uint8_t uid[PN532_MAX_UID_LEN];
+    uint8_t sak;                     /* detected only, 106A */
+    uint8_t atqa[2];
+    uint8_t brty;
+    uint16_t repeats;                /* Duplicates merged into this event while it was pending */
+    int64_t timestamp_us;            /* esp_timer time of the first occurrence */
+} nfc_event_t;
+
+typedef void (*nfc_event_handler_t)(const nfc_event_t *ev, void *ctx);
+
+typedef struct {
+    uint32_t posted;
+    uint32_t delivered;
+    uint32_t coalesced;              /* Posts merged into a pending duplicate */
+    uint32_t overflows;              /* Oldest pending event dropped to make room */
+    unsigned high_water;             /* Most events pending at once */
+    uint32_t max_wait_us;            /* Occurrence -> handler start */
+    uint32_t max_handler_us;
+} nfc_events_stats_t;
+
+/**
+ * Create the ring and NFC_EVENTS_CONSUMERS tasks running handler. Call once,
+ * before the first nfc_events_post(). False if a task could not be created.
+ */
+bool nfc_events_start(nfc_event_handler_t handler, void *ctx);
+
+/**
+ * Run the handler for the oldest pending event, waiting up to wait ticks for
+ * one. The consumer tasks loop on this. False if nothing arrived in time.
+ */
+bool nfc_events_dispatch(TickType_t wait);
+
+/**
+ * Fill ev for kind, stamped now; tag (NULL for none) supplies UID and type.
+ */
+void nfc_event_init(nfc_event_t *ev, nfc_event_kind_t kind, const pn532_tag_info_t *tag);
+
+/**
+ * Queue ev without blocking. If the newest pending event for the same UID
+ * has the same kind, ev is merged into it (repeats + 1). On a full ring the
+ * oldest pending event is dropped, so the latest state always gets through.
+ */
+void nfc_events_post(const nfc_event_t *ev);
+
+/**
+ * Rebuild the tag info the event was made from; tg is 0, as the target may
+ * already be released by the time a consumer runs.
+ */
+void nfc_event_to_tag_info(const nfc_event_t *ev, pn532_tag_info_t *tag);
+
+void nfc_events_get_stats(nfc_events_stats_t *stats);
+void nfc_events_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NFC_EVENTS_H */
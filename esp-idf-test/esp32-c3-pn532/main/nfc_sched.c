@@ -0,0 +1,90 @@
+/**
+ * Polling scheduler implementation.
+ * See TECHNICAL_DOCUMENTATION.md §12.4.
+ */
+
+#include "nfc_sched.h"
+#include <string.h>
+
+void nfc_sched_init(nfc_sched_t *s, const nfc_sched_config_t *cfg)
+{
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    if (s->cfg.mode_count == 0) {
+        s->cfg.mode_count = 1;
+    }
+    if (s->cfg.mode_count > NFC_SCHED_MAX_MODES) {
+        s->cfg.mode_count = NFC_SCHED_MAX_MODES;
+    }
+    if (s->cfg.max_gap < s->cfg.mode_count) {
+        s->cfg.max_gap = s->cfg.mode_count;
+    }
+    if (s->cfg.min_weight == 0) {
+        s->cfg.min_weight = 1;
+    }
+    if (s->cfg.rate_shift == 0 || s->cfg.rate_shift > 8) {
+        s->cfg.rate_shift = (s->cfg.rate_shift == 0) ? 1 : 8;
+    }
+}
+
+/*
+ * A mode that has waited max_gap - 1 slots gets this one, oldest first, which
+ * bounds detection latency for rare types. Otherwise smooth weighted round
+ * robin: every mode earns its weight in credit, the richest one runs and pays
+ * the total. Shares follow the weights without bursts of one mode.
+ */
+unsigned nfc_sched_next(nfc_sched_t *s)
+{
+    unsigned n = s->cfg.mode_count;
+    unsigned pick = n;
+
+    for (unsigned i = 0; i < n; i++) {
+        if (s->gap[i] + 1 >= s->cfg.max_gap && (pick == n || s->gap[i] > s->gap[pick])) {
+            pick = i;
+        }
+    }
+
+    int32_t total = 0;
+    for (unsigned i = 0; i < n; i++) {
+        int32_t w = (int32_t)s->cfg.min_weight + s->stats[i].rate;
+        s->credit[i] += w;
+        total += w;
+    }
+    if (pick < n) {
+        s->stats[pick].forced++;
+    } else {
+        pick = 0;
+        for (unsigned i = 1; i < n; i++) {
+            if (s->credit[i] > s->credit[pick]) {
+                pick = i;
+            }
+        }
+    }
+    s->credit[pick] -= total;
+
+    for (unsigned i = 0; i < n; i++) {
+        s->gap[i] = (i == pick) ? 0 : s->gap[i] + 1;
+    }
+    return pick;
+}
+
+void nfc_sched_report(nfc_sched_t *s, unsigned idx, bool hit)
+{
+    if (idx >= s->cfg.mode_count) {
+        return;
+    }
+    nfc_sched_mode_stats_t *st = &s->stats[idx];
+    st->polls++;
+    int32_t target = hit ? NFC_SCHED_RATE_ONE : 0;
+    if (hit) {
+        st->hits++;
+    }
+    st->rate = (uint16_t)(st->rate + ((target - (int32_t)st->rate) >> s->cfg.rate_shift));
+}
+
+void nfc_sched_get_stats(const nfc_sched_t *s, unsigned idx, nfc_sched_mode_stats_t *stats)
+{
+    if (idx < s->cfg.mode_count && stats) {
+        *stats = s->stats[idx];
+    }
+}
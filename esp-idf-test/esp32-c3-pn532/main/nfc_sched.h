@@ -0,0 +1,67 @@
+/**
+ * Multi-protocol polling scheduler: decides which modulation (106A, 106B,
+ * FeliCa 212/424) the next InListPassiveTarget slot uses. Slots are shared
+ * by smooth weighted round robin; a mode's weight grows with its recent hit
+ * rate, and every mode is polled at least once per max_gap slots.
+ * Pure C with no ESP-IDF dependencies, so it also builds on the host.
+ */
+
+#ifndef NFC_SCHED_H
+#define NFC_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NFC_SCHED_MAX_MODES   4
+#define NFC_SCHED_RATE_ONE    1024   /* Fixed-point 1.0 for hit rates and weights */
+
+typedef struct {
+    uint8_t modes[NFC_SCHED_MAX_MODES];  /* PN532_BAUDRATE_* values */
+    unsigned mode_count;                 /* 1..NFC_SCHED_MAX_MODES */
+    unsigned max_gap;                    /* Every mode polled at least once per max_gap slots */
+    uint16_t min_weight;                 /* Weight of a mode never seen, /NFC_SCHED_RATE_ONE */
+    uint8_t rate_shift;                  /* Hit-rate EWMA: rate += (hit - rate) >> rate_shift */
+} nfc_sched_config_t;
+
+typedef struct {
+    uint32_t polls;
+    uint32_t hits;
+    uint32_t forced;     /* Slots taken because max_gap was reached */
+    uint16_t rate;       /* EWMA hit rate, /NFC_SCHED_RATE_ONE */
+} nfc_sched_mode_stats_t;
+
+typedef struct {
+    nfc_sched_config_t cfg;
+    nfc_sched_mode_stats_t stats[NFC_SCHED_MAX_MODES];
+    int32_t credit[NFC_SCHED_MAX_MODES];
+    unsigned gap[NFC_SCHED_MAX_MODES];   /* Slots since the mode was last polled */
+} nfc_sched_t;
+
+/**
+ * Reset s to cfg. Out-of-range fields are clamped: mode_count to
+ * 1..NFC_SCHED_MAX_MODES, max_gap to at least mode_count, min_weight to at
+ * least 1, rate_shift to 1..8.
+ */
+void nfc_sched_init(nfc_sched_t *s, const nfc_sched_config_t *cfg);
+
+/**
+ * Index (into cfg.modes) of the mode to poll in the next slot.
+ */
+unsigned nfc_sched_next(nfc_sched_t *s);
+
+/**
+ * Feed back the outcome of the slot nfc_sched_next() returned.
+ */
+void nfc_sched_report(nfc_sched_t *s, unsigned idx, bool hit);
+
+void nfc_sched_get_stats(const nfc_sched_t *s, unsigned idx, nfc_sched_mode_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NFC_SCHED_H */
@@ -4,138 +4,381 @@
  */
 
 #include "pn532.h"
-#include "driver/i2c.h"
+#include "pn532_transport.h"
+#include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include <string.h>
 
 static const char *TAG = "pn532";
 
-#define I2C_PORT          I2C_NUM_0
-#define I2C_WRITE_TICKS   pdMS_TO_TICKS(PN532_I2C_WRITE_TIMEOUT_MS)
-#define I2C_READ_TICKS    pdMS_TO_TICKS(PN532_I2C_READ_TIMEOUT_MS)
-
 /* ACK frame (6 bytes, doc §4.2); when read via I2C, ready byte 0x01 precedes */
 static const uint8_t ACK_FRAME[] = { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00 };
 
-static bool s_i2c_installed = false;
+#if PN532_TWO_PHASE_READ
+/* NACK frame (doc §4.2): asks the PN532 to re-send its last response */
+static const uint8_t NACK_FRAME[] = { 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00 };
+#endif
+
+/* 00 00 FF, LEN/LCS (5 bytes when extended), TFI, command */
+#define FRAME_HEADER_MAX 10
 
-/* Build command frame (doc §8.1). Frame buffer must hold at least 10 + param_count bytes. */
-static int build_command_frame(uint8_t *frame, size_t frame_max,
-                               uint8_t command, const uint8_t *params, unsigned param_count)
+/*
+ * Command frame header (doc §8.1): preamble, start code, LEN/LCS, TFI and
+ * command. LEN = TFI + command + params; above 255 the extended form
+ * FF FF LENM LENL LCS is used (doc §4.4). Returns the header length.
+ */
+static size_t build_frame_header(uint8_t hdr[FRAME_HEADER_MAX], uint8_t command, size_t param_len)
 {
-    /* LEN = TFI + command + params */
-    unsigned len = 1 + 1 + param_count;
-    uint8_t lcs = (uint8_t)((0x00 - len) & 0xFF);
-    uint16_t dcs_sum = PN532_TFI_HOST_TO_PN532 + command;
+    size_t len = 2 + param_len;
     size_t i = 0;
 
-    if (frame_max < (size_t)(9 + param_count)) {
-        return -1;
+    hdr[i++] = PN532_PREAMBLE;
+    hdr[i++] = PN532_STARTCODE1;
+    hdr[i++] = PN532_STARTCODE2;
+    if (len > 0xFF) {
+        uint8_t lenm = (uint8_t)(len >> 8);
+        uint8_t lenl = (uint8_t)len;
+        hdr[i++] = 0xFF;
+        hdr[i++] = 0xFF;
+        hdr[i++] = lenm;
+        hdr[i++] = lenl;
+        hdr[i++] = (uint8_t)(0x00 - lenm - lenl);
+    } else {
+        hdr[i++] = (uint8_t)len;
+        hdr[i++] = (uint8_t)(0x00 - len);
     }
+    hdr[i++] = PN532_TFI_HOST_TO_PN532;
+    hdr[i++] = command;
+    return i;
+}
 
-    frame[i++] = PN532_PREAMBLE;
-    frame[i++] = PN532_STARTCODE1;
-    frame[i++] = PN532_STARTCODE2;
-    frame[i++] = (uint8_t)len;
-    frame[i++] = lcs;
-    frame[i++] = PN532_TFI_HOST_TO_PN532;
-    frame[i++] = command;
+/* Check ready through the bus backend (doc §7.3) */
+static bool is_ready(pn532_dev_t *dev)
+{
+    return dev->transport->is_ready(dev);
+}
 
-    for (unsigned k = 0; k < param_count; k++) {
-        frame[i] = params[k];
-        dcs_sum += params[k];
-        i++;
+/* Ready without blocking: IRQ level if wired, else one status-byte read */
+static bool ready_now(pn532_dev_t *dev)
+{
+    if (dev->irq_sem) {
+        return gpio_get_level(dev->config.irq_gpio) == 0;
     }
+    return is_ready(dev);
+}
 
-    frame[i++] = (uint8_t)((0x00 - (dcs_sum & 0xFF)) & 0xFF);
-    frame[i++] = PN532_POSTAMBLE;
-    return (int)i;
+/*
+ * Ready for a pn532_process() step that reads need bytes. On stream buses the
+ * first byte is not enough: reading the rest would wait on the wire, so wait
+ * until all need bytes are buffered.
+ */
+static bool process_ready(pn532_dev_t *dev, size_t need)
+{
+    if (dev->transport->buffered) {
+        return dev->transport->buffered(dev) >= need;
+    }
+    return ready_now(dev);
 }
 
-static pn532_err_t i2c_write(const uint8_t *data, size_t len)
+static void IRAM_ATTR irq_gpio_isr(void *arg)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    if (!cmd) {
-        return PN532_ERR_I2C;
+    pn532_dev_t *dev = arg;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(dev->irq_sem, &woken);
+    TaskHandle_t task = dev->notify_task;
+    if (task) {
+        vTaskNotifyGiveFromISR(task, &woken);
     }
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (PN532_I2C_ADDR_7BIT << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write(cmd, data, len, true);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(I2C_PORT, cmd, I2C_WRITE_TICKS);
-    i2c_cmd_link_delete(cmd);
-    return (ret == ESP_OK) ? PN532_OK : PN532_ERR_I2C;
+    portYIELD_FROM_ISR(woken);
 }
 
-static pn532_err_t i2c_read(uint8_t *buf, size_t len)
+/* Configure the IRQ line; on failure the driver stays in polling mode */
+static void irq_init(pn532_dev_t *dev)
 {
-    if (len == 0) {
-        return PN532_OK;
+    int pin = dev->config.irq_gpio;
+    if (pin < 0) {
+        return;
+    }
+
+    gpio_config_t io = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode         = GPIO_MODE_INPUT,
+        .pull_up_en   = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type    = GPIO_INTR_NEGEDGE,
+    };
+    if (gpio_config(&io) != ESP_OK) {
+        ESP_LOGW(TAG, "IRQ gpio_config failed, using polling");
+        return;
     }
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    if (!cmd) {
-        return PN532_ERR_I2C;
+
+    /* Static storage in the handle: no heap, and nothing to free on failure */
+    SemaphoreHandle_t sem = xSemaphoreCreateBinaryStatic(&dev->irq_sem_buf);
+
+    /* Service may already be installed by another module */
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGW(TAG, "gpio_install_isr_service failed %d, using polling", ret);
+        return;
     }
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (PN532_I2C_ADDR_7BIT << 1) | I2C_MASTER_READ, true);
-    if (len > 1) {
-        i2c_master_read(cmd, buf, len - 1, I2C_MASTER_ACK);
+    /* Set before the handler is live: the ISR gives dev->irq_sem */
+    dev->irq_sem = sem;
+    if (gpio_isr_handler_add(pin, irq_gpio_isr, dev) != ESP_OK) {
+        ESP_LOGW(TAG, "IRQ handler add failed, using polling");
+        dev->irq_sem = NULL;
+        return;
     }
-    i2c_master_read_byte(cmd, buf + len - 1, I2C_MASTER_NACK);
-    i2c_master_stop(cmd);
-    esp_err_t ret = i2c_master_cmd_begin(I2C_PORT, cmd, I2C_READ_TICKS);
-    i2c_cmd_link_delete(cmd);
-    return (ret == ESP_OK) ? PN532_OK : PN532_ERR_I2C;
 }
 
-/* Check ready: read 1 byte, true if 0x01 (doc §7.3) */
-static bool is_ready(void)
+/*
+ * Wait for IRQ low. The level is checked before blocking so an edge that
+ * fired before we got here (or a stale give) cannot cause a missed wake-up.
+ */
+static pn532_err_t wait_ready_irq(pn532_dev_t *dev, uint32_t timeout_ms)
 {
-    uint8_t b;
-    if (i2c_read(&b, 1) != PN532_OK) {
-        return false;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+
+    for (;;) {
+        if (gpio_get_level(dev->config.irq_gpio) == 0) {
+            return PN532_OK;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            return PN532_ERR_TIMEOUT;
+        }
+        (void)xSemaphoreTake(dev->irq_sem, timeout - elapsed);
     }
-    return (b == PN532_I2C_READY);
 }
 
-/* Wait for ready with timeout and 10ms poll (doc §7.4) */
-static pn532_err_t wait_ready(uint32_t timeout_ms)
+/*
+ * Starting point for each wait class's expected time to ready (doc §7.4).
+ * RF commands vary with the tag; the values cover NTAG/MIFARE exchanges and
+ * an empty-field list with one activation retry. AutoPoll answers after
+ * whole 150 ms periods.
+ */
+static const uint32_t READY_HINT_SEED_US[PN532_HINT_COUNT] = {
+    [PN532_HINT_ACK]      = 1000,
+    [PN532_HINT_LOCAL]    = 1000,
+    [PN532_HINT_LIST]     = 4000,
+    [PN532_HINT_EXCHANGE] = 3000,
+    [PN532_HINT_AUTOPOLL] = 150000,
+};
+
+static pn532_ready_hint_t response_hint_of(uint8_t command)
+{
+    switch (command) {
+        case PN532_CMD_IN_LIST_PASSIVE_TARGET:
+            return PN532_HINT_LIST;
+        case PN532_CMD_IN_DATA_EXCHANGE:
+        case PN532_CMD_DIAGNOSE:
+            return PN532_HINT_EXCHANGE;
+        case PN532_CMD_IN_AUTO_POLL:
+            return PN532_HINT_AUTOPOLL;
+        default:
+            return PN532_HINT_LOCAL;
+    }
+}
+
+/*
+ * Status polling without IRQ (doc §7.4). Spin until the frame is expected,
+ * then double the gap between reads; past PN532_READY_SPIN_MAX_US (or right
+ * away if the frame is due later) sleep whole ticks, doubling up to
+ * PN532_READY_POLL_MS. The time the frame took feeds the class's expectation
+ * (moving average, 1/4 weight), so e.g. a burst of NTAG writes soon spins
+ * just past the EEPROM time instead of sleeping into the next tick. The
+ * sample is the middle of the last not-ready/ready interval: a tick sleep
+ * would otherwise report the tick phase and keep the class sleeping.
+ */
+static pn532_err_t wait_ready_poll(pn532_dev_t *dev, uint32_t timeout_ms, pn532_ready_hint_t hint)
 {
-    uint32_t elapsed = 0;
-    while (elapsed < timeout_ms) {
-        if (is_ready()) {
+    uint32_t expect_us = dev->ready_hint_us[hint];
+    int64_t spin_us = (expect_us < PN532_READY_SPIN_MAX_US) ? PN532_READY_SPIN_MAX_US : 0;
+    TickType_t max_ticks = pdMS_TO_TICKS(PN532_READY_POLL_MS);
+    if (max_ticks < 1) {
+        max_ticks = 1;
+    }
+    int64_t start = esp_timer_get_time();
+    int64_t timeout_us = (int64_t)timeout_ms * 1000;
+    uint32_t gap_us = PN532_READY_SPIN_US;
+    TickType_t ticks = 1;
+    int64_t not_ready_at = 0;
+
+    for (;;) {
+        if (is_ready(dev)) {
+            int32_t took = (int32_t)((not_ready_at + esp_timer_get_time() - start) / 2);
+            dev->ready_hint_us[hint] = (uint32_t)((int32_t)expect_us + (took - (int32_t)expect_us) / 4);
             return PN532_OK;
         }
-        vTaskDelay(pdMS_TO_TICKS(PN532_READY_POLL_MS));
-        elapsed += PN532_READY_POLL_MS;
+        int64_t elapsed = esp_timer_get_time() - start;
+        not_ready_at = elapsed;
+        if (elapsed >= timeout_us) {
+            return PN532_ERR_TIMEOUT;
+        }
+        if (elapsed + gap_us <= spin_us) {
+            esp_rom_delay_us(gap_us);
+            if (elapsed >= expect_us) {
+                gap_us *= 2;
+            }
+        } else {
+            vTaskDelay(ticks);
+            ticks = (ticks * 2 < max_ticks) ? ticks * 2 : max_ticks;
+        }
     }
-    return PN532_ERR_TIMEOUT;
 }
 
-/* Send command and receive ACK (doc §8.2) */
-static pn532_err_t send_command(uint8_t command, const uint8_t *params, unsigned param_count)
+/* Wait for ready with timeout: IRQ line if wired, else adaptive status polling (doc §7.4) */
+static pn532_err_t wait_ready(pn532_dev_t *dev, uint32_t timeout_ms, pn532_ready_hint_t hint)
 {
-    uint8_t frame[32];
-    int frame_len = build_command_frame(frame, sizeof(frame), command, params, param_count);
-    if (frame_len < 0) {
-        return PN532_ERR_SIZE;
+    if (dev->irq_sem) {
+        return wait_ready_irq(dev, timeout_ms);
+    }
+    if (dev->transport->wait_ready) {
+        return dev->transport->wait_ready(dev, timeout_ms);
+    }
+    return wait_ready_poll(dev, timeout_ms, hint);
+}
+
+#if PN532_STATS_ENABLE
+/* Open a stats exchange (doc §15.3); one whose response is never read is dropped */
+static void stats_begin(pn532_dev_t *dev, uint8_t command)
+{
+    int64_t now = esp_timer_get_time();
+    dev->stats_cur.open = true;
+    dev->stats_cur.command = command;
+    dev->stats_cur.start_us = now;
+    dev->stats_cur.mark_us = now;
+    memset(dev->stats_cur.phase_us, 0, sizeof(dev->stats_cur.phase_us));
+}
+
+/* Charge the time since the previous mark to phase */
+static void stats_phase(pn532_dev_t *dev, pn532_phase_t phase)
+{
+    if (!dev->stats_cur.open) {
+        return;
     }
+    int64_t now = esp_timer_get_time();
+    dev->stats_cur.phase_us[phase] += (uint32_t)(now - dev->stats_cur.mark_us);
+    dev->stats_cur.mark_us = now;
+}
 
-    pn532_err_t err = i2c_write(frame, (size_t)frame_len);
-    if (err != PN532_OK) {
+/* Slots fill in order and are only freed by a reset, so the first free one ends the search */
+static pn532_command_stats_t *stats_slot(pn532_stats_t *st, uint8_t command)
+{
+    for (unsigned k = 0; k < PN532_STATS_COMMANDS; k++) {
+        pn532_command_stats_t *c = &st->commands[k];
+        if (c->count == 0) {
+            c->command = command;
+            return c;
+        }
+        if (c->command == command) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+/* Close the open exchange with its outcome; returns err for tail calls */
+static pn532_err_t stats_end(pn532_dev_t *dev, pn532_err_t err)
+{
+    if (!dev->stats_cur.open) {
+        return err;
+    }
+    dev->stats_cur.open = false;
+    pn532_stats_t *st = &dev->stats;
+    if ((unsigned)err < PN532_ERR_COUNT) {
+        st->results[err]++;
+    }
+    pn532_command_stats_t *c = stats_slot(st, dev->stats_cur.command);
+    if (!c) {
+        st->untracked++;
         return err;
     }
 
-    err = wait_ready(PN532_ACK_TIMEOUT_MS);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - dev->stats_cur.start_us);
+    unsigned bucket = 0;
+    while (bucket < PN532_STATS_BUCKETS - 1 && us >= ((uint32_t)PN532_STATS_BUCKET0_US << bucket)) {
+        bucket++;
+    }
+    c->count++;
+    c->hist[bucket]++;
     if (err != PN532_OK) {
-        return err;
+        c->errors++;
+    }
+    if (us > c->max_us) {
+        c->max_us = us;
+    }
+    for (unsigned p = 0; p < PN532_PHASE_COUNT; p++) {
+        uint32_t phase_us = dev->stats_cur.phase_us[p];
+        c->phase_total_us[p] += phase_us;
+        if (phase_us > c->phase_max_us[p]) {
+            c->phase_max_us[p] = phase_us;
+        }
+    }
+    return err;
+}
+#else
+#define stats_begin(dev, command)  ((void)0)
+#define stats_phase(dev, phase)    ((void)0)
+#define stats_end(dev, err)        (err)
+#endif
+
+/*
+ * Write a command frame gathered from header, parameter pieces and trailer
+ * in one bus transaction; parameters are never copied into a frame buffer
+ * (doc §8.1). No ACK handling.
+ */
+static pn532_err_t write_commandv(pn532_dev_t *dev, uint8_t command,
+                                  const pn532_iovec_t *params, unsigned count)
+{
+    if (count > PN532_IOV_MAX - 2) {
+        return PN532_ERR_SIZE;
+    }
+
+    size_t param_len = 0;
+    uint8_t dcs_sum = (uint8_t)(PN532_TFI_HOST_TO_PN532 + command);
+    for (unsigned k = 0; k < count; k++) {
+        for (size_t j = 0; j < params[k].len; j++) {
+            dcs_sum += params[k].data[j];
+        }
+        param_len += params[k].len;
     }
+    if (2 + param_len > PN532_FRAME_MAX_DATA) {
+        return PN532_ERR_SIZE;
+    }
+
+    uint8_t hdr[FRAME_HEADER_MAX];
+    const uint8_t trailer[] = { (uint8_t)(0x00 - dcs_sum), PN532_POSTAMBLE };
+    pn532_iovec_t iov[PN532_IOV_MAX];
+    unsigned n = 0;
+    iov[n++] = (pn532_iovec_t){ hdr, build_frame_header(hdr, command, param_len) };
+    for (unsigned k = 0; k < count; k++) {
+        if (params[k].len > 0) {
+            iov[n++] = params[k];
+        }
+    }
+    iov[n++] = (pn532_iovec_t){ trailer, sizeof(trailer) };
+    return dev->transport->writev(dev, iov, n);
+}
+
+/* Build and write a command frame from one contiguous parameter block */
+static pn532_err_t write_command(pn532_dev_t *dev, uint8_t command,
+                                 const uint8_t *params, unsigned param_count)
+{
+    const pn532_iovec_t iov = { params, param_count };
+    return write_commandv(dev, command, &iov, 1);
+}
 
-    /* Read 7 bytes: ready + 6-byte ACK */
+/* Read 7 bytes (ready + 6-byte ACK) once the PN532 is ready and check them */
+static pn532_err_t read_ack(pn532_dev_t *dev)
+{
     uint8_t ack_buf[7];
-    err = i2c_read(ack_buf, 7);
+    pn532_err_t err = dev->transport->read(dev, ack_buf, 7);
     if (err != PN532_OK) {
         return err;
     }
@@ -145,229 +388,1238 @@ static pn532_err_t send_command(uint8_t command, const uint8_t *params, unsigned
     return PN532_OK;
 }
 
-/* Read response: wait ready, read 64 bytes, find 00 00 FF, validate LCS/TFI/DCS, copy data (doc §8.3) */
-static pn532_err_t read_response(uint32_t timeout_ms, uint8_t *data, size_t data_max, size_t *data_len)
+/* Send gathered command and receive ACK (doc §8.2) */
+static pn532_err_t send_commandv(pn532_dev_t *dev, uint8_t command,
+                                 const pn532_iovec_t *params, unsigned count)
 {
-    pn532_err_t err = wait_ready(timeout_ms);
-    if (err != PN532_OK) {
-        return err;
+    if (dev->async.state != PN532_ASYNC_IDLE) {
+        return PN532_ERR_BUSY;
     }
 
-    uint8_t raw[PN532_RESPONSE_BUFFER_LEN];
-    err = i2c_read(raw, sizeof(raw));
+    stats_begin(dev, command);
+    pn532_err_t err = write_commandv(dev, command, params, count);
+    stats_phase(dev, PN532_PHASE_WRITE);
     if (err != PN532_OK) {
-        return err;
+        return stats_end(dev, err);
+    }
+
+    err = wait_ready(dev, PN532_ACK_TIMEOUT_MS, PN532_HINT_ACK);
+    if (err == PN532_OK) {
+        err = read_ack(dev);
     }
+    dev->response_hint = response_hint_of(command);
+    stats_phase(dev, PN532_PHASE_ACK);
+    return (err != PN532_OK) ? stats_end(dev, err) : PN532_OK;
+}
 
-    /* Find start sequence 0x00 0x00 0xFF in first 32 bytes */
-    int start = -1;
-    for (int i = 0; i <= 29; i++) {
+/* Send command and receive ACK (doc §8.2) */
+static pn532_err_t send_command(pn532_dev_t *dev, uint8_t command,
+                                const uint8_t *params, unsigned param_count)
+{
+    const pn532_iovec_t iov = { params, param_count };
+    return send_commandv(dev, command, &iov, 1);
+}
+
+/*
+ * Locate 00 00 FF in raw and decode LEN (normal or extended frame, doc §4.3).
+ * On success *hdr_end is the index of TFI and *frame_len is LEN.
+ */
+static pn532_err_t parse_frame_header(const uint8_t *raw, size_t raw_len,
+                                      size_t *hdr_end, unsigned *frame_len)
+{
+    size_t start = raw_len;
+    for (size_t i = 0; i + 2 < raw_len; i++) {
         if (raw[i] == 0x00 && raw[i + 1] == 0x00 && raw[i + 2] == 0xFF) {
             start = i;
             break;
         }
     }
-    if (start < 0) {
+    if (start + 5 > raw_len) {
         return PN532_ERR_PARSE;
     }
 
     uint8_t len_byte = raw[start + 3];
-    uint8_t lcs     = raw[start + 4];
-    if (((len_byte + lcs) & 0xFF) != 0x00) {
-        return PN532_ERR_CHECKSUM;
+    uint8_t lcs      = raw[start + 4];
+
+    if (len_byte == 0xFF && lcs == 0xFF) {
+        /* Extended frame: 00 00 FF FF FF LENM LENL LCS */
+        if (start + 8 > raw_len) {
+            return PN532_ERR_PARSE;
+        }
+        uint8_t lenm = raw[start + 5];
+        uint8_t lenl = raw[start + 6];
+        if (((lenm + lenl + raw[start + 7]) & 0xFF) != 0x00) {
+            return PN532_ERR_CHECKSUM;
+        }
+        *frame_len = ((unsigned)lenm << 8) | lenl;
+        *hdr_end = start + 8;
+    } else {
+        if (((len_byte + lcs) & 0xFF) != 0x00) {
+            return PN532_ERR_CHECKSUM;
+        }
+        *frame_len = len_byte;
+        *hdr_end = start + 5;
+    }
+
+    if (*frame_len == 0) {
+        return PN532_ERR_PARSE;
+    }
+    return PN532_OK;
+}
+
+/* Validate TFI/DCS of a complete raw frame; *data points at its data inside raw (doc §8.3) */
+static pn532_err_t parse_response_view(const uint8_t *raw, size_t raw_len,
+                                       const uint8_t **data, size_t *data_len)
+{
+    size_t tfi_idx;
+    unsigned len;
+    pn532_err_t err = parse_frame_header(raw, raw_len, &tfi_idx, &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (tfi_idx + len + 1 > raw_len) {
+        return PN532_ERR_SIZE;
     }
 
-    if (raw[start + 5] != PN532_TFI_PN532_TO_HOST) {
+    if (raw[tfi_idx] != PN532_TFI_PN532_TO_HOST) {
         return PN532_ERR_PARSE;
     }
 
     /* Data length = LEN - 1 (TFI only in LEN) */
-    unsigned data_length = len_byte - 1;
-    uint8_t dcs = raw[start + 5 + len_byte];
+    unsigned data_length = len - 1;
+    uint8_t dcs = raw[tfi_idx + len];
 
     /* Checksum: TFI + data + DCS should sum to 0 mod 256 */
-    uint16_t sum = raw[start + 5];
+    uint16_t sum = raw[tfi_idx];
     for (unsigned i = 0; i < data_length; i++) {
-        sum += raw[start + 6 + i];
+        sum += raw[tfi_idx + 1 + i];
     }
     sum += dcs;
     if ((sum & 0xFF) != 0x00) {
         return PN532_ERR_CHECKSUM;
     }
 
-    if (data_length > data_max) {
-        return PN532_ERR_SIZE;
-    }
-    memcpy(data, raw + start + 6, data_length);
+    *data = raw + tfi_idx + 1;
     *data_len = data_length;
     return PN532_OK;
 }
 
-/* --- Public API --- */
-
-pn532_err_t pn532_init(void)
+/* parse_response_view() plus a copy of the data into the caller's buffer */
+static pn532_err_t parse_response_frame(const uint8_t *raw, size_t raw_len,
+                                        uint8_t *data, size_t data_max, size_t *data_len)
 {
-    if (s_i2c_installed) {
-        return PN532_OK;
+    const uint8_t *view;
+    size_t view_len;
+    pn532_err_t err = parse_response_view(raw, raw_len, &view, &view_len);
+    if (err != PN532_OK) {
+        return err;
     }
+    if (view_len > data_max) {
+        return PN532_ERR_SIZE;
+    }
+    memcpy(data, view, view_len);
+    *data_len = view_len;
+    return PN532_OK;
+}
 
-    i2c_config_t conf = {
-        .mode             = I2C_MODE_MASTER,
-        .sda_io_num       = PN532_I2C_SDA_GPIO,
-        .scl_io_num       = PN532_I2C_SCL_GPIO,
-        .sda_pullup_en    = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en    = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = PN532_I2C_FREQ_HZ,
-        .clk_flags        = 0,
-    };
-
-    esp_err_t ret = i2c_param_config(I2C_PORT, &conf);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "i2c_param_config failed %d", ret);
-        return PN532_ERR_I2C;
+/*
+ * Size a frame from its first bytes (ready slot + header, doc §4.3): *total is
+ * everything up to and including the postamble. Extended LENM/LENL are only
+ * used for sizing here; LCS is checked again on the full frame.
+ */
+static pn532_err_t frame_extent(const uint8_t *hdr, size_t hdr_read, size_t data_max, size_t *total)
+{
+    size_t start = hdr_read;
+    for (size_t i = 0; i + 2 < hdr_read; i++) {
+        if (hdr[i] == 0x00 && hdr[i + 1] == 0x00 && hdr[i + 2] == 0xFF) {
+            start = i;
+            break;
+        }
+    }
+    if (start + 5 > hdr_read) {
+        return PN532_ERR_PARSE;
     }
 
-    ret = i2c_driver_install(I2C_PORT, I2C_MODE_MASTER, 0, 0, 0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "i2c_driver_install failed %d", ret);
-        return PN532_ERR_I2C;
+    size_t hdr_len;
+    unsigned len;
+    if (hdr[start + 3] == 0xFF && hdr[start + 4] == 0xFF) {
+        if (start + 7 > hdr_read) {
+            return PN532_ERR_PARSE;
+        }
+        len = ((unsigned)hdr[start + 5] << 8) | hdr[start + 6];
+        hdr_len = 8;
+    } else {
+        if (((hdr[start + 3] + hdr[start + 4]) & 0xFF) != 0x00) {
+            return PN532_ERR_CHECKSUM;
+        }
+        len = hdr[start + 3];
+        hdr_len = 5;
+    }
+    if (len == 0) {
+        return PN532_ERR_PARSE;
     }
-    s_i2c_installed = true;
+    if (len - 1 > data_max) {
+        return PN532_ERR_SIZE;
+    }
+
+    /* Bytes before 00 00 FF (ready + preamble) + header + TFI/data + DCS + postamble */
+    *total = start + hdr_len + len + 2;
     return PN532_OK;
 }
 
-void pn532_wakeup(void)
-{
-    const uint8_t wakeup[] = { 0x55, 0x55, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    (void)i2c_write(wakeup, sizeof(wakeup));
-    /* Caller must delay 50 ms */
-}
+/*
+ * Stream buses: bytes to wait for before the header read in pn532_process().
+ * An extended header (00 00 FF FF FF LENM LENL LCS) is this long, and every
+ * response frame is longer, so the wait never outlasts the frame.
+ */
+#define STREAM_HEADER_LEN 8
 
-pn532_err_t pn532_get_firmware_version(pn532_firmware_version_t *version)
+/*
+ * Stream read, first part (HSU, doc §7.6): received bytes are consumed, so
+ * read the normal header (ready slot + 00 00 FF LEN LCS) and three more bytes
+ * if it is an extended frame. *have gets the bytes now in raw, *total the
+ * whole frame's length.
+ */
+static pn532_err_t read_stream_header(pn532_dev_t *dev, uint8_t *raw, size_t raw_max, size_t data_max,
+                                      size_t *have, size_t *total)
 {
-    if (!version) {
-        return PN532_ERR_RESPONSE;
+    *have = 6;
+    pn532_err_t err = dev->transport->read(dev, raw, *have);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (raw[4] == 0xFF && raw[5] == 0xFF) {
+        err = dev->transport->read_continue(dev, raw + *have, 3);
+        if (err != PN532_OK) {
+            return err;
+        }
+        *have += 3;
     }
 
-    pn532_err_t err = send_command(PN532_CMD_GET_FIRMWARE_VERSION, NULL, 0);
+    err = frame_extent(raw, *have, data_max, total);
     if (err != PN532_OK) {
         return err;
     }
+    return (*total > raw_max) ? PN532_ERR_SIZE : PN532_OK;
+}
 
-    uint8_t data[8];
-    size_t len = 0;
-    err = read_response(PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+/* Stream read: the header, then exactly the rest. No NACK round trip is needed. */
+static pn532_err_t read_frame_stream(pn532_dev_t *dev, uint8_t *raw, size_t raw_max,
+                                     size_t *raw_len, size_t data_max)
+{
+    size_t have;
+    size_t total;
+    pn532_err_t err = read_stream_header(dev, raw, raw_max, data_max, &have, &total);
     if (err != PN532_OK) {
         return err;
     }
-    if (len < 5 || data[0] != PN532_RSP_GET_FIRMWARE_VERSION) {
-        return PN532_ERR_RESPONSE;
+    err = dev->transport->read_continue(dev, raw + have, total - have);
+    if (err != PN532_OK) {
+        return err;
     }
-
-    version->ic      = data[1];
-    version->version = data[2];
-    version->revision = data[3];
-    version->support = data[4];
+    *raw_len = total;
     return PN532_OK;
 }
 
-pn532_err_t pn532_sam_config(void)
+#if PN532_TWO_PHASE_READ
+/*
+ * Two-phase read (doc §8.3): read ready byte + header to learn LEN, then ask
+ * the PN532 to re-send the frame with a NACK and read exactly that many bytes.
+ * Each bus read (I2C, or SPI data read) restarts at the frame start, so the
+ * "remaining bytes" cannot be fetched by a second plain read.
+ * request_frame() is the first phase; pn532_process() runs the second in a
+ * later call instead of waiting for the re-send (doc §8.4).
+ */
+static pn532_err_t request_frame(pn532_dev_t *dev, size_t raw_max, size_t data_max, size_t *total)
 {
-    const uint8_t params[] = { 0x01, 0x14, 0x01 }; /* Mode, Timeout, IRQ */
-    pn532_err_t err = send_command(PN532_CMD_SAM_CONFIGURATION, params, 3);
+    uint8_t hdr[PN532_FRAME_HEADER_READ_LEN];
+    pn532_err_t err = dev->transport->read(dev, hdr, sizeof(hdr));
     if (err != PN532_OK) {
         return err;
     }
 
-    uint8_t data[4];
-    size_t len = 0;
-    err = read_response(PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+    err = frame_extent(hdr, sizeof(hdr), data_max, total);
     if (err != PN532_OK) {
         return err;
     }
-    if (len < 1 || data[0] != PN532_RSP_SAM_CONFIGURATION) {
-        return PN532_ERR_RESPONSE;
+    if (*total > raw_max) {
+        return PN532_ERR_SIZE;
     }
-    return PN532_OK;
+    return pn532_transport_write(dev, NACK_FRAME, sizeof(NACK_FRAME));
 }
 
-pn532_err_t pn532_read_passive_target(uint32_t timeout_ms, pn532_tag_info_t *tag)
+static pn532_err_t read_frame(pn532_dev_t *dev, uint8_t *raw, size_t raw_max, size_t *raw_len,
+                              size_t data_max)
 {
-    if (!tag) {
-        return PN532_ERR_RESPONSE;
+    size_t total;
+    pn532_err_t err = request_frame(dev, raw_max, data_max, &total);
+    if (err != PN532_OK) {
+        return err;
     }
-    memset(tag, 0, sizeof(*tag));
+    /* The re-sent frame is ready about as fast as an ACK */
+    err = wait_ready(dev, PN532_ACK_TIMEOUT_MS, PN532_HINT_ACK);
+    if (err != PN532_OK) {
+        return err;
+    }
+    err = dev->transport->read(dev, raw, total);
+    if (err != PN532_OK) {
+        return err;
+    }
+    *raw_len = total;
+    return PN532_OK;
+}
+#else
+/* Single-phase read: fixed-size read, frame located by the parser */
+static pn532_err_t read_frame(pn532_dev_t *dev, uint8_t *raw, size_t raw_max, size_t *raw_len,
+                              size_t data_max)
+{
+    /* Fixed 64-byte read unless the caller expects a larger payload */
+    size_t n = PN532_RESPONSE_BUFFER_LEN;
+    if (data_max + 16 > n) {
+        n = data_max + 16;
+    }
+    if (n > raw_max) {
+        n = raw_max;
+    }
+    pn532_err_t err = dev->transport->read(dev, raw, n);
+    if (err != PN532_OK) {
+        return err;
+    }
+    *raw_len = n;
+    return PN532_OK;
+}
+#endif
 
-    const uint8_t params[] = { 0x01, PN532_BAUDRATE_106K_ISO14443A }; /* MaxTargets=1, BaudRate */
-    pn532_err_t err = send_command(PN532_CMD_IN_LIST_PASSIVE_TARGET, params, 2);
+/* Read and validate a response the PN532 already has ready (doc §8.3) */
+static pn532_err_t receive_response(pn532_dev_t *dev, uint8_t *data, size_t data_max, size_t *data_len)
+{
+    size_t raw_len = 0;
+    pn532_err_t err = dev->transport->read_continue
+                      ? read_frame_stream(dev, dev->frame, sizeof(dev->frame), &raw_len, data_max)
+                      : read_frame(dev, dev->frame, sizeof(dev->frame), &raw_len, data_max);
     if (err != PN532_OK) {
         return err;
     }
+    return parse_response_frame(dev->frame, raw_len, data, data_max, data_len);
+}
 
-    uint8_t data[24];
-    size_t len = 0;
-    err = read_response(timeout_ms, data, sizeof(data), &len);
-    if (err == PN532_ERR_TIMEOUT) {
-        return PN532_ERR_NOT_FOUND;
+/*
+ * Like read_response() but without the copy: *data points at the validated
+ * data inside dev->frame, valid until the next command on dev.
+ */
+static pn532_err_t read_response_view(pn532_dev_t *dev, uint32_t timeout_ms, size_t data_max,
+                                      const uint8_t **data, size_t *data_len)
+{
+    pn532_err_t err = wait_ready(dev, timeout_ms, dev->response_hint);
+    stats_phase(dev, PN532_PHASE_WAIT);
+    if (err != PN532_OK) {
+        return stats_end(dev, err);
+    }
+    size_t raw_len = 0;
+    err = dev->transport->read_continue
+          ? read_frame_stream(dev, dev->frame, sizeof(dev->frame), &raw_len, data_max)
+          : read_frame(dev, dev->frame, sizeof(dev->frame), &raw_len, data_max);
+    if (err == PN532_OK) {
+        err = parse_response_view(dev->frame, raw_len, data, data_len);
     }
+    stats_phase(dev, PN532_PHASE_READ);
+    return stats_end(dev, err);
+}
+
+/* Read response: wait ready, read frame, validate LCS/TFI/DCS, copy data (doc §8.3) */
+static pn532_err_t read_response(pn532_dev_t *dev, uint32_t timeout_ms,
+                                 uint8_t *data, size_t data_max, size_t *data_len)
+{
+    pn532_err_t err = wait_ready(dev, timeout_ms, dev->response_hint);
+    stats_phase(dev, PN532_PHASE_WAIT);
     if (err != PN532_OK) {
-        return err;
+        return stats_end(dev, err);
     }
-    if (len < 7 || data[0] != PN532_RSP_IN_LIST_PASSIVE_TARGET) {
+    err = receive_response(dev, data, data_max, data_len);
+    stats_phase(dev, PN532_PHASE_READ);
+    return stats_end(dev, err);
+}
+
+/*
+ * Parse one ISO14443A target record (doc §6.4): Tg, SENS_RES[2], SEL_RES,
+ * NFCIDLength, NFCID1[], then ATS[] when SEL_RES bit 5 says ISO14443-4.
+ * *consumed (optional) receives the record length including the ATS.
+ */
+static pn532_err_t parse_target_106a(const uint8_t *rec, size_t len,
+                                     pn532_tag_info_t *tag, size_t *consumed)
+{
+    if (len < 5) {
         return PN532_ERR_RESPONSE;
     }
-    if (data[1] == 0) {
-        return PN532_ERR_NOT_FOUND;
-    }
 
-    tag->atqa[0]     = data[3];
-    tag->atqa[1]     = data[4];
-    tag->sak        = data[5];
-    tag->uid_length = data[6];
+    tag->tg         = rec[0];
+    tag->atqa[0]    = rec[1];
+    tag->atqa[1]    = rec[2];
+    tag->sak        = rec[3];
+    tag->uid_length = rec[4];
 
-    if (tag->uid_length > PN532_MAX_UID_LEN || (7 + tag->uid_length) > len) {
+    if (tag->uid_length > PN532_MAX_UID_LEN || (size_t)(5 + tag->uid_length) > len) {
         return PN532_ERR_SIZE;
     }
-    memcpy(tag->uid, data + 7, tag->uid_length);
+    memcpy(tag->uid, rec + 5, tag->uid_length);
     tag->type = pn532_determine_tag_type(tag->sak, tag->uid_length);
+
+    if (consumed) {
+        size_t n = 5 + tag->uid_length;
+        if ((tag->sak & 0x20) && n < len) {
+            n += rec[n]; /* ATS length byte counts itself */
+            if (n > len) {
+                return PN532_ERR_SIZE;
+            }
+        }
+        *consumed = n;
+    }
     return PN532_OK;
 }
 
-pn532_err_t pn532_release_target(void)
+/* FeliCa record: Tg, POL_RES length, 0x01, IDm(8), PMm(8), [system code(2)] */
+static pn532_err_t parse_target_felica(const uint8_t *rec, size_t len, uint8_t brty,
+                                       pn532_tag_info_t *tag)
 {
-    const uint8_t params[] = { 0x00 };
-    pn532_err_t err = send_command(PN532_CMD_IN_RELEASE, params, 1);
-    if (err != PN532_OK) {
-        return err;
+    if (len < 3 + PN532_FELICA_IDM_LEN || rec[1] < 2 + PN532_FELICA_IDM_LEN || 1u + rec[1] > len) {
+        return PN532_ERR_RESPONSE;
     }
+    tag->tg = rec[0];
+    tag->brty = brty;
+    tag->type = PN532_TAG_FELICA;
+    tag->uid_length = PN532_FELICA_IDM_LEN;
+    memcpy(tag->uid, rec + 3, PN532_FELICA_IDM_LEN);
+    return PN532_OK;
+}
 
-    uint8_t data[4];
-    size_t len = 0;
-    err = read_response(PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
-    if (err != PN532_OK) {
-        return err;
-    }
-    if (len < 2 || data[0] != PN532_RSP_IN_RELEASE) {
+/* 106B record: Tg, ATQB(12: 0x50, PUPI(4), AppData(4), ProtInfo(3)), ATTRIB_RES length, ATTRIB_RES */
+static pn532_err_t parse_target_106b(const uint8_t *rec, size_t len, pn532_tag_info_t *tag)
+{
+    if (len < 14 || rec[1] != 0x50 || 14u + rec[13] > len) {
         return PN532_ERR_RESPONSE;
     }
+    tag->tg = rec[0];
+    tag->brty = PN532_BAUDRATE_106K_ISO14443B;
+    tag->type = PN532_TAG_ISO14443B;
+    tag->uid_length = PN532_ISO14443B_PUPI_LEN;
+    memcpy(tag->uid, rec + 2, PN532_ISO14443B_PUPI_LEN);
     return PN532_OK;
 }
 
-pn532_tag_type_t pn532_determine_tag_type(uint8_t sak, uint8_t uid_length)
+/* --- Public API --- */
+
+pn532_err_t pn532_init(pn532_dev_t *dev, const pn532_config_t *config)
 {
-    switch (sak) {
-        case 0x00:
-            return (uid_length == 7) ? PN532_TAG_NTAG : PN532_TAG_MIFARE_ULTRALIGHT;
-        case 0x08:
-            return PN532_TAG_MIFARE_CLASSIC_1K;
-        case 0x18:
-            return PN532_TAG_MIFARE_CLASSIC_4K;
-        case 0x10:
-        case 0x11:
-            return PN532_TAG_MIFARE_PLUS;
-        case 0x20:
-            return PN532_TAG_MIFARE_DESFIRE;
+    if (dev->initialized) {
+        return PN532_OK;
+    }
+
+    *dev = (pn532_dev_t){ .config = *config, .async.state = PN532_ASYNC_IDLE };
+    memcpy(dev->ready_hint_us, READY_HINT_SEED_US, sizeof(dev->ready_hint_us));
+
+    switch (config->transport) {
+        case PN532_TRANSPORT_SPI:
+            dev->transport = &pn532_spi_transport;
+            break;
+        case PN532_TRANSPORT_HSU:
+            dev->transport = &pn532_hsu_transport;
+            break;
         default:
-            return PN532_TAG_UNKNOWN;
+            dev->transport = &pn532_i2c_transport;
+            break;
     }
+    pn532_err_t err = dev->transport->init(dev);
+    if (err != PN532_OK) {
+        return err;
+    }
+    dev->initialized = true;
+    irq_init(dev);
+
+    if (config->rst_gpio >= 0) {
+        gpio_config_t io = {
+            .pin_bit_mask = 1ULL << config->rst_gpio,
+            .mode         = GPIO_MODE_OUTPUT,
+            .pull_up_en   = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type    = GPIO_INTR_DISABLE,
+        };
+        if (gpio_config(&io) == ESP_OK) {
+            (void)pn532_hard_reset(dev);
+        } else {
+            ESP_LOGW(TAG, "RST gpio_config failed, reset line unused");
+            dev->config.rst_gpio = -1;
+        }
+    }
+
+    ESP_LOGI(TAG, "bus %s, ready wait: %s", dev->transport->name,
+             dev->irq_sem ? "IRQ" : "status polling");
+    return PN532_OK;
+}
+
+pn532_err_t pn532_hard_reset(pn532_dev_t *dev)
+{
+    if (dev->config.rst_gpio < 0) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+    /* RSTPDN low resets the chip; it needs a short settle time after release */
+    gpio_set_level(dev->config.rst_gpio, 0);
+    vTaskDelay(pdMS_TO_TICKS(PN532_RESET_PULSE_MS));
+    gpio_set_level(dev->config.rst_gpio, 1);
+    vTaskDelay(pdMS_TO_TICKS(PN532_POST_RESET_MS));
+    return PN532_OK;
+}
+
+/* Wake-up + SAMConfiguration until the PN532 answers, backing off between tries */
+static pn532_err_t recover_sam(pn532_dev_t *dev)
+{
+    pn532_err_t err = PN532_ERR_TIMEOUT;
+    for (int i = 0; i < PN532_RECOVER_TRIES && err != PN532_OK; i++) {
+        pn532_wakeup(dev);
+        vTaskDelay(pdMS_TO_TICKS(PN532_RECOVER_WAKEUP_MS << i));
+        err = pn532_sam_config(dev);
+    }
+    return err;
+}
+
+pn532_err_t pn532_recover(pn532_dev_t *dev)
+{
+    int64_t start = esp_timer_get_time();
+    pn532_recovery_stats_t *rs = &dev->recovery_stats;
+    rs->attempts++;
+
+    /* Whatever was in flight is lost */
+    dev->async.state = PN532_ASYNC_IDLE;
+    dev->async.cb = NULL;
+#if PN532_STATS_ENABLE
+    dev->stats_cur.open = false;
+#endif
+
+    pn532_err_t err = PN532_OK;
+    if (dev->transport->recover) {
+        err = dev->transport->recover(dev);
+        if (err != PN532_OK) {
+            ESP_LOGW(TAG, "%s bus recovery failed %d", dev->transport->name, err);
+        }
+    }
+    if (err == PN532_OK) {
+        /* An ACK aborts a command the PN532 may still be running (doc §4.2) */
+        (void)pn532_transport_write(dev, ACK_FRAME, sizeof(ACK_FRAME));
+        err = recover_sam(dev);
+    }
+    if (err != PN532_OK && pn532_hard_reset(dev) == PN532_OK) {
+        rs->hard_resets++;
+        err = recover_sam(dev);
+    }
+
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+    rs->total_us += us;
+    rs->last_us = us;
+    if (us > rs->max_us) {
+        rs->max_us = us;
+    }
+    if (err != PN532_OK) {
+        rs->failures++;
+    }
+    return err;
+}
+
+void pn532_wakeup(pn532_dev_t *dev)
+{
+    const uint8_t wakeup[] = { 0x55, 0x55, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    (void)pn532_transport_write(dev, wakeup, sizeof(wakeup));
+    /* Caller must delay 50 ms */
+}
+
+pn532_err_t pn532_get_firmware_version(pn532_dev_t *dev, pn532_firmware_version_t *version)
+{
+    if (!version) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    pn532_err_t err = send_command(dev, PN532_CMD_GET_FIRMWARE_VERSION, NULL, 0);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    uint8_t data[8];
+    size_t len = 0;
+    err = read_response(dev, PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 5 || data[0] != PN532_RSP_GET_FIRMWARE_VERSION) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    version->ic      = data[1];
+    version->version = data[2];
+    version->revision = data[3];
+    version->support = data[4];
+    return PN532_OK;
+}
+
+pn532_err_t pn532_sam_config(pn532_dev_t *dev)
+{
+    const uint8_t params[] = { 0x01, 0x14, 0x01 }; /* Mode, Timeout, IRQ */
+    pn532_err_t err = send_command(dev, PN532_CMD_SAM_CONFIGURATION, params, 3);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    uint8_t data[4];
+    size_t len = 0;
+    err = read_response(dev, PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 1 || data[0] != PN532_RSP_SAM_CONFIGURATION) {
+        return PN532_ERR_RESPONSE;
+    }
+    return PN532_OK;
+}
+
+/* RFConfiguration (doc §6.9): one CfgItem and its ConfigurationData */
+static pn532_err_t rf_configuration(pn532_dev_t *dev, uint8_t item, const uint8_t *cfg, unsigned cfg_len)
+{
+    uint8_t params[4];
+    if (cfg_len + 1 > sizeof(params)) {
+        return PN532_ERR_SIZE;
+    }
+    params[0] = item;
+    memcpy(params + 1, cfg, cfg_len);
+    pn532_err_t err = send_command(dev, PN532_CMD_RF_CONFIGURATION, params, cfg_len + 1);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    uint8_t data[4];
+    size_t len = 0;
+    err = read_response(dev, PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 1 || data[0] != PN532_RSP_RF_CONFIGURATION) {
+        return PN532_ERR_RESPONSE;
+    }
+    return PN532_OK;
+}
+
+pn532_err_t pn532_set_rf_field(pn532_dev_t *dev, bool on)
+{
+    /* AutoRFCA only matters for active (peer-to-peer) mode; keep it off */
+    const uint8_t cfg = on ? PN532_RFCFG_RF_FIELD_ON : 0x00;
+    return rf_configuration(dev, PN532_RFCFG_ITEM_RF_FIELD, &cfg, 1);
+}
+
+pn532_err_t pn532_set_rf_timings(pn532_dev_t *dev, uint8_t atr_res_timeout, uint8_t retry_timeout)
+{
+    if (atr_res_timeout > PN532_RFCFG_TIMEOUT_MAX_CODE || retry_timeout > PN532_RFCFG_TIMEOUT_MAX_CODE) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+    const uint8_t cfg[] = { 0x00, atr_res_timeout, retry_timeout }; /* RFU, ATR_RES, non-DEP */
+    return rf_configuration(dev, PN532_RFCFG_ITEM_TIMINGS, cfg, sizeof(cfg));
+}
+
+pn532_err_t pn532_set_max_retries(pn532_dev_t *dev, uint8_t atr, uint8_t psl,
+                                  uint8_t passive_activation)
+{
+    const uint8_t cfg[] = { atr, psl, passive_activation };
+    return rf_configuration(dev, PN532_RFCFG_ITEM_MAX_RETRIES, cfg, sizeof(cfg));
+}
+
+/* SetSerialBaudRate BR codes (doc §6.8), index = code */
+static const uint32_t HSU_BAUD_RATES[] = {
+    9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 1288000,
+};
+
+pn532_err_t pn532_set_serial_baud_rate(pn532_dev_t *dev, uint32_t baud)
+{
+    if (!dev->transport->set_baud) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+    uint8_t br = 0;
+    while (br < sizeof(HSU_BAUD_RATES) / sizeof(HSU_BAUD_RATES[0]) && HSU_BAUD_RATES[br] != baud) {
+        br++;
+    }
+    if (br == sizeof(HSU_BAUD_RATES) / sizeof(HSU_BAUD_RATES[0])) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+    if (baud == dev->bus_baud) {
+        return PN532_OK;
+    }
+
+    pn532_err_t err = send_command(dev, PN532_CMD_SET_SERIAL_BAUD_RATE, &br, 1);
+    if (err != PN532_OK) {
+        return err;
+    }
+    uint8_t data[4];
+    size_t len = 0;
+    err = read_response(dev, PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 1 || data[0] != PN532_RSP_SET_SERIAL_BAUD_RATE) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* The PN532 switches only once it has seen our ACK, sent at the old rate */
+    err = pn532_transport_write(dev, ACK_FRAME, sizeof(ACK_FRAME));
+    if (err != PN532_OK) {
+        return err;
+    }
+    uint32_t old_baud = dev->bus_baud;
+    err = dev->transport->set_baud(dev, baud);
+    if (err != PN532_OK) {
+        return err;
+    }
+    vTaskDelay(pdMS_TO_TICKS(PN532_BAUD_SWITCH_MS));
+
+    pn532_firmware_version_t fw;
+    err = pn532_get_firmware_version(dev, &fw);
+    if (err != PN532_OK) {
+        ESP_LOGW(TAG, "no answer at %lu baud, back to %lu", (unsigned long)baud,
+                 (unsigned long)old_baud);
+        (void)dev->transport->set_baud(dev, old_baud);
+        return err;
+    }
+    ESP_LOGI(TAG, "HSU at %lu baud", (unsigned long)baud);
+    return PN532_OK;
+}
+
+/* InListPassiveTarget for one target (MaxTg=1); params[1] is BrTy and picks the record parser */
+static pn532_err_t list_one_target(pn532_dev_t *dev, uint32_t timeout_ms, const uint8_t *params,
+                                   unsigned param_count, pn532_tag_info_t *tag)
+{
+    memset(tag, 0, sizeof(*tag));
+    pn532_err_t err = send_command(dev, PN532_CMD_IN_LIST_PASSIVE_TARGET, params, param_count);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    uint8_t data[PN532_RESPONSE_BUFFER_LEN];
+    size_t len = 0;
+    err = read_response(dev, timeout_ms, data, sizeof(data), &len);
+    if (err == PN532_ERR_TIMEOUT) {
+        return PN532_ERR_NOT_FOUND;
+    }
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 2 || data[0] != PN532_RSP_IN_LIST_PASSIVE_TARGET) {
+        return PN532_ERR_RESPONSE;
+    }
+    /* NbTg = 0: retries (RFConfiguration item 5) ran out on an empty field */
+    if (data[1] == 0) {
+        return PN532_ERR_NOT_FOUND;
+    }
+
+    switch (params[1]) {
+        case PN532_BAUDRATE_212K_FELICA:
+        case PN532_BAUDRATE_424K_FELICA:
+            return parse_target_felica(data + 2, len - 2, params[1], tag);
+        case PN532_BAUDRATE_106K_ISO14443B:
+            return parse_target_106b(data + 2, len - 2, tag);
+        default:
+            return parse_target_106a(data + 2, len - 2, tag, NULL);
+    }
+}
+
+pn532_err_t pn532_read_passive_target(pn532_dev_t *dev, uint32_t timeout_ms, pn532_tag_info_t *tag)
+{
+    if (!tag) {
+        return PN532_ERR_RESPONSE;
+    }
+    return pn532_list_passive_target(dev, PN532_BAUDRATE_106K_ISO14443A, timeout_ms, tag);
+}
+
+pn532_err_t pn532_list_passive_target(pn532_dev_t *dev, uint8_t brty, uint32_t timeout_ms,
+                                      pn532_tag_info_t *tag)
+{
+    if (!tag) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* MaxTg=1, BrTy, InitiatorData */
+    switch (brty) {
+        case PN532_BAUDRATE_106K_ISO14443A: {
+            const uint8_t params[] = { 0x01, brty };
+            return list_one_target(dev, timeout_ms, params, sizeof(params), tag);
+        }
+        case PN532_BAUDRATE_106K_ISO14443B: {
+            const uint8_t params[] = { 0x01, brty, 0x00 };  /* AFI 0: every application family */
+            return list_one_target(dev, timeout_ms, params, sizeof(params), tag);
+        }
+        case PN532_BAUDRATE_212K_FELICA:
+        case PN532_BAUDRATE_424K_FELICA: {
+            /* POLLING: 00, system code, request code 01 (system code back), time slot 0 */
+            const uint8_t params[] = { 0x01, brty, 0x00, (uint8_t)(PN532_FELICA_SYSTEM_CODE_ANY >> 8),
+                                       (uint8_t)PN532_FELICA_SYSTEM_CODE_ANY, 0x01, 0x00 };
+            return list_one_target(dev, timeout_ms, params, sizeof(params), tag);
+        }
+        default:
+            return PN532_ERR_UNSUPPORTED;
+    }
+}
+
+pn532_err_t pn532_reselect_target(pn532_dev_t *dev, pn532_tag_info_t *tag)
+{
+    if (!tag || tag->uid_length == 0 || tag->uid_length > PN532_MAX_UID_LEN) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* InitiatorData = UID: only that card answers the select (doc §6.4) */
+    uint8_t params[2 + PN532_MAX_UID_LEN] = { 0x01, PN532_BAUDRATE_106K_ISO14443A };
+    memcpy(params + 2, tag->uid, tag->uid_length);
+    pn532_tag_info_t found;
+    pn532_err_t err = list_one_target(dev, PN532_TAG_DETECT_TIMEOUT_MS, params,
+                                      2 + tag->uid_length, &found);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (found.uid_length != tag->uid_length || memcmp(found.uid, tag->uid, tag->uid_length) != 0) {
+        return PN532_ERR_NOT_FOUND;
+    }
+    tag->tg = found.tg;
+    return PN532_OK;
+}
+
+pn532_err_t pn532_inventory(pn532_dev_t *dev, uint32_t timeout_ms, pn532_tag_info_t *tags,
+                            unsigned max_tags, unsigned *count)
+{
+    if (!tags || !count || max_tags == 0) {
+        return PN532_ERR_RESPONSE;
+    }
+    *count = 0;
+    if (max_tags > PN532_MAX_TARGETS) {
+        max_tags = PN532_MAX_TARGETS;
+    }
+    memset(tags, 0, max_tags * sizeof(*tags));
+
+    const uint8_t params[] = { (uint8_t)max_tags, PN532_BAUDRATE_106K_ISO14443A };
+    pn532_err_t err = send_command(dev, PN532_CMD_IN_LIST_PASSIVE_TARGET, params, 2);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    /*
+     * Two 106A records with 10-byte UIDs and full ATSes overrun any small
+     * buffer, so read the whole frame and parse the records in place.
+     */
+    const uint8_t *data;
+    size_t len = 0;
+    err = read_response_view(dev, timeout_ms, PN532_FRAME_MAX_DATA, &data, &len);
+    if (err == PN532_ERR_TIMEOUT) {
+        return PN532_ERR_NOT_FOUND;
+    }
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 2 || data[0] != PN532_RSP_IN_LIST_PASSIVE_TARGET) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* Records are back to back; the ATS (if any) must be skipped to find the next */
+    unsigned nb_tg = data[1];
+    size_t off = 2;
+    for (unsigned n = 0; n < nb_tg && n < max_tags; n++) {
+        size_t used = 0;
+        err = parse_target_106a(data + off, len - off, &tags[n], &used);
+        if (err != PN532_OK) {
+            return err;
+        }
+        off += used;
+        (*count)++;
+    }
+    return (*count > 0) ? PN532_OK : PN532_ERR_NOT_FOUND;
+}
+
+pn532_err_t pn532_data_exchange(pn532_dev_t *dev, uint8_t tg, const uint8_t *tx, size_t tx_len,
+                                uint8_t *rx, size_t rx_max, size_t *rx_len)
+{
+    uint8_t status;
+    pn532_err_t err = pn532_data_exchange_status(dev, tg, tx, tx_len, rx, rx_max, rx_len, &status);
+    if (err == PN532_OK && (status & PN532_STATUS_MI)) {
+        /* The caller can't see the MI bit, so a partial reply is a size error */
+        return PN532_ERR_SIZE;
+    }
+    return err;
+}
+
+pn532_err_t pn532_data_exchange_status(pn532_dev_t *dev, uint8_t tg, const uint8_t *tx, size_t tx_len,
+                                       uint8_t *rx, size_t rx_max, size_t *rx_len, uint8_t *status)
+{
+    if ((!tx && tx_len > 0) || !rx_len || !status || (!rx && rx_max > 0)) {
+        return PN532_ERR_RESPONSE;
+    }
+    if (tx_len > PN532_DATA_EXCHANGE_MAX_LEN) {
+        return PN532_ERR_SIZE;
+    }
+
+    /* Tg and DataOut go out as separate pieces of one frame, no staging copy */
+    const pn532_iovec_t params[] = { { &tg, 1 }, { tx, tx_len } };
+    pn532_err_t err = send_commandv(dev, PN532_CMD_IN_DATA_EXCHANGE, params, 2);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    /* Response: 0x41, Status, DataIn[]; DataIn is copied once, frame -> rx */
+    const uint8_t *data;
+    size_t len = 0;
+    err = read_response_view(dev, PN532_RESPONSE_TIMEOUT_MS, 2 + rx_max, &data, &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 2 || data[0] != PN532_RSP_IN_DATA_EXCHANGE) {
+        return PN532_ERR_RESPONSE;
+    }
+    *status = data[1];
+    if ((data[1] & PN532_STATUS_ERROR_MASK) != 0x00) {
+        return PN532_ERR_TARGET;
+    }
+    if (len - 2 > rx_max) {
+        return PN532_ERR_SIZE;
+    }
+    memcpy(rx, data + 2, len - 2);
+    *rx_len = len - 2;
+    return PN532_OK;
+}
+
+bool pn532_presence_check_supported(const pn532_tag_info_t *tag)
+{
+    if (!tag) {
+        return false;
+    }
+    return tag->type == PN532_TAG_NTAG || tag->type == PN532_TAG_MIFARE_ULTRALIGHT ||
+           tag->type == PN532_TAG_ISO14443B || (tag->sak & 0x20) != 0;
+}
+
+pn532_err_t pn532_target_present(pn532_dev_t *dev, const pn532_tag_info_t *tag)
+{
+    if (!pn532_presence_check_supported(tag)) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+
+    if (tag->type == PN532_TAG_NTAG || tag->type == PN532_TAG_MIFARE_ULTRALIGHT) {
+        /* READ of page 0 is the cheapest command a Type 2 tag answers */
+        uint8_t page[PN532_NTAG_READ_LEN];
+        pn532_err_t err = pn532_ntag_read(dev, tag->tg, 0, page);
+        if (err == PN532_ERR_TARGET || err == PN532_ERR_RESPONSE) {
+            return PN532_ERR_NOT_FOUND;
+        }
+        return err;
+    }
+
+    /* ISO14443-4: Diagnose attention request, Status 0x00 = card answered */
+    const uint8_t params[] = { PN532_DIAG_ATTENTION_REQUEST };
+    pn532_err_t err = send_command(dev, PN532_CMD_DIAGNOSE, params, 1);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    uint8_t data[4];
+    size_t len = 0;
+    err = read_response(dev, PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 2 || data[0] != PN532_RSP_DIAGNOSE) {
+        return PN532_ERR_RESPONSE;
+    }
+    return (data[1] == 0x00) ? PN532_OK : PN532_ERR_NOT_FOUND;
+}
+
+pn532_err_t pn532_release_target(pn532_dev_t *dev)
+{
+    const uint8_t params[] = { 0x00 };
+    pn532_err_t err = send_command(dev, PN532_CMD_IN_RELEASE, params, 1);
+    if (err != PN532_OK) {
+        return err;
+    }
+
+    uint8_t data[4];
+    size_t len = 0;
+    err = read_response(dev, PN532_RESPONSE_TIMEOUT_MS, data, sizeof(data), &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 2 || data[0] != PN532_RSP_IN_RELEASE) {
+        return PN532_ERR_RESPONSE;
+    }
+    return PN532_OK;
+}
+
+pn532_err_t pn532_start_autopoll(pn532_dev_t *dev, const pn532_autopoll_config_t *config)
+{
+    if (!config || config->type_count == 0 || config->type_count > PN532_AUTOPOLL_MAX_TYPES ||
+        config->poll_nr == 0 || config->period == 0 || config->period > 0x0F) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    uint8_t params[2 + PN532_AUTOPOLL_MAX_TYPES];
+    params[0] = config->poll_nr;
+    params[1] = config->period;
+    memcpy(params + 2, config->types, config->type_count);
+
+    /* The response only arrives once a target is found or PollNr is exhausted */
+    return send_command(dev, PN532_CMD_IN_AUTO_POLL, params, 2 + config->type_count);
+}
+
+pn532_err_t pn532_autopoll_wait(pn532_dev_t *dev, uint32_t timeout_ms, pn532_tag_info_t *tag)
+{
+    if (!tag) {
+        return PN532_ERR_RESPONSE;
+    }
+    memset(tag, 0, sizeof(*tag));
+
+    uint8_t data[PN532_RESPONSE_BUFFER_LEN];
+    size_t len = 0;
+    pn532_err_t err = read_response(dev, timeout_ms, data, sizeof(data), &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < 2 || data[0] != PN532_RSP_IN_AUTO_POLL) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* NbTg, then per target: Type, AutoPollTargetDataLength, TargetData */
+    size_t off = 2;
+    for (uint8_t n = 0; n < data[1]; n++) {
+        if (off + 2 > len) {
+            return PN532_ERR_SIZE;
+        }
+        uint8_t type = data[off];
+        uint8_t rec_len = data[off + 1];
+        off += 2;
+        if (off + rec_len > len) {
+            return PN532_ERR_SIZE;
+        }
+        bool is_106a = (type == PN532_AUTOPOLL_TYPE_GENERIC_106K ||
+                        type == PN532_AUTOPOLL_TYPE_MIFARE ||
+                        type == PN532_AUTOPOLL_TYPE_ISO14443_4A);
+        if (is_106a) {
+            return parse_target_106a(data + off, rec_len, tag, NULL);
+        }
+        if (type == PN532_AUTOPOLL_TYPE_FELICA_212 || type == PN532_AUTOPOLL_TYPE_FELICA_424) {
+            uint8_t brty = (type == PN532_AUTOPOLL_TYPE_FELICA_212) ? PN532_BAUDRATE_212K_FELICA
+                                                                    : PN532_BAUDRATE_424K_FELICA;
+            return parse_target_felica(data + off, rec_len, brty, tag);
+        }
+        if (type == PN532_AUTOPOLL_TYPE_ISO14443_4B) {
+            return parse_target_106b(data + off, rec_len, tag);
+        }
+        off += rec_len;
+    }
+    return PN532_ERR_NOT_FOUND;
+}
+
+pn532_err_t pn532_stop_autopoll(pn532_dev_t *dev)
+{
+    /* An ACK frame from the host aborts the command in progress (doc §4.2) */
+    return pn532_transport_write(dev, ACK_FRAME, sizeof(ACK_FRAME));
+}
+
+/* --- Asynchronous command API (doc §8.4) --- */
+
+static void async_complete(pn532_dev_t *dev, pn532_err_t err, size_t len)
+{
+    pn532_async_cb_t cb = dev->async.cb;
+    void *ctx = dev->async.ctx;
+    dev->async.state = PN532_ASYNC_IDLE;
+    dev->async.cb = NULL;
+    if (cb) {
+        cb(err, (err == PN532_OK) ? dev->async.rx : NULL, (err == PN532_OK) ? len : 0, ctx);
+    }
+}
+
+pn532_err_t pn532_submit(pn532_dev_t *dev, uint8_t command, const uint8_t *params, unsigned param_count,
+                         uint32_t timeout_ms, pn532_async_cb_t cb, void *ctx)
+{
+    if (dev->async.state != PN532_ASYNC_IDLE) {
+        return PN532_ERR_BUSY;
+    }
+
+    pn532_err_t err = write_command(dev, command, params, param_count);
+    if (err != PN532_OK) {
+        return err;
+    }
+    dev->async.cb = cb;
+    dev->async.ctx = ctx;
+    dev->async.response_timeout_ms = timeout_ms;
+    dev->async.deadline_us = esp_timer_get_time() + (int64_t)PN532_ACK_TIMEOUT_MS * 1000;
+    dev->async.state = PN532_ASYNC_SENT;
+    return PN532_OK;
+}
+
+pn532_async_state_t pn532_process(pn532_dev_t *dev)
+{
+    switch (dev->async.state) {
+        case PN532_ASYNC_SENT:
+            if (process_ready(dev, sizeof(ACK_FRAME))) {
+                pn532_err_t err = read_ack(dev);
+                if (err != PN532_OK) {
+                    async_complete(dev, err, 0);
+                    break;
+                }
+                dev->async.deadline_us = esp_timer_get_time() +
+                                      (int64_t)dev->async.response_timeout_ms * 1000;
+                dev->async.state = PN532_ASYNC_ACKED;
+            } else if (esp_timer_get_time() >= dev->async.deadline_us) {
+                async_complete(dev, PN532_ERR_TIMEOUT, 0);
+            }
+            break;
+
+        case PN532_ASYNC_ACKED:
+            if (process_ready(dev, STREAM_HEADER_LEN)) {
+                if (dev->transport->read_continue) {
+                    /* Stream bus: header now, the rest once all of it has arrived */
+                    pn532_err_t err = read_stream_header(dev, dev->frame, sizeof(dev->frame),
+                                                         sizeof(dev->async.rx), &dev->async.frame_have,
+                                                         &dev->async.frame_len);
+                    if (err != PN532_OK) {
+                        async_complete(dev, err, 0);
+                        break;
+                    }
+                    dev->async.deadline_us = esp_timer_get_time() +
+                                          (int64_t)PN532_UART_READ_TIMEOUT_MS * 1000;
+                    dev->async.state = PN532_ASYNC_RECEIVING;
+                    break;
+                }
+#if PN532_TWO_PHASE_READ
+                /* Header and NACK now; the re-sent frame is read by a later call */
+                pn532_err_t err = request_frame(dev, sizeof(dev->frame), sizeof(dev->async.rx),
+                                                &dev->async.frame_len);
+                if (err != PN532_OK) {
+                    async_complete(dev, err, 0);
+                    break;
+                }
+                dev->async.deadline_us = esp_timer_get_time() + (int64_t)PN532_ACK_TIMEOUT_MS * 1000;
+                dev->async.state = PN532_ASYNC_NACKED;
+#else
+                dev->async.state = PN532_ASYNC_RESPONSE;
+                size_t len = 0;
+                pn532_err_t err = receive_response(dev, dev->async.rx, sizeof(dev->async.rx), &len);
+                async_complete(dev, err, len);
+#endif
+            } else if (esp_timer_get_time() >= dev->async.deadline_us) {
+                /* Abort so the late response does not collide with the next command */
+                (void)pn532_transport_write(dev, ACK_FRAME, sizeof(ACK_FRAME));
+                async_complete(dev, PN532_ERR_TIMEOUT, 0);
+            }
+            break;
+
+        case PN532_ASYNC_NACKED:
+            if (ready_now(dev)) {
+                dev->async.state = PN532_ASYNC_RESPONSE;
+                size_t len = 0;
+                pn532_err_t err = dev->transport->read(dev, dev->frame, dev->async.frame_len);
+                if (err == PN532_OK) {
+                    err = parse_response_frame(dev->frame, dev->async.frame_len, dev->async.rx,
+                                               sizeof(dev->async.rx), &len);
+                }
+                async_complete(dev, err, len);
+            } else if (esp_timer_get_time() >= dev->async.deadline_us) {
+                (void)pn532_transport_write(dev, ACK_FRAME, sizeof(ACK_FRAME));
+                async_complete(dev, PN532_ERR_TIMEOUT, 0);
+            }
+            break;
+
+        case PN532_ASYNC_RECEIVING:
+            if (process_ready(dev, dev->async.frame_len - dev->async.frame_have)) {
+                dev->async.state = PN532_ASYNC_RESPONSE;
+                size_t len = 0;
+                size_t have = dev->async.frame_have;
+                pn532_err_t err = dev->transport->read_continue(dev, dev->frame + have,
+                                                                dev->async.frame_len - have);
+                if (err == PN532_OK) {
+                    err = parse_response_frame(dev->frame, dev->async.frame_len, dev->async.rx,
+                                               sizeof(dev->async.rx), &len);
+                }
+                async_complete(dev, err, len);
+            } else if (esp_timer_get_time() >= dev->async.deadline_us) {
+                (void)pn532_transport_write(dev, ACK_FRAME, sizeof(ACK_FRAME));
+                async_complete(dev, PN532_ERR_TIMEOUT, 0);
+            }
+            break;
+
+        case PN532_ASYNC_IDLE:
+        case PN532_ASYNC_RESPONSE:
+        default:
+            break;
+    }
+    return dev->async.state;
+}
+
+void pn532_cancel(pn532_dev_t *dev)
+{
+    if (dev->async.state == PN532_ASYNC_IDLE) {
+        return;
+    }
+    (void)pn532_transport_write(dev, ACK_FRAME, sizeof(ACK_FRAME));
+    dev->async.state = PN532_ASYNC_IDLE;
+    dev->async.cb = NULL;
+}
+
+void pn532_set_notify_task(pn532_dev_t *dev, TaskHandle_t task)
+{
+    dev->notify_task = task;
+}
+
+pn532_tag_type_t pn532_determine_tag_type(uint8_t sak, uint8_t uid_length)
+{
+    switch (sak) {
+        case 0x00:
+            return (uid_length == 7) ? PN532_TAG_NTAG : PN532_TAG_MIFARE_ULTRALIGHT;
+        case 0x08:
+            return PN532_TAG_MIFARE_CLASSIC_1K;
+        case 0x18:
+            return PN532_TAG_MIFARE_CLASSIC_4K;
+        case 0x10:
+        case 0x11:
+            return PN532_TAG_MIFARE_PLUS;
+        case 0x20:
+            return PN532_TAG_MIFARE_DESFIRE;
+        default:
+            return PN532_TAG_UNKNOWN;
+    }
+}
+
+void pn532_get_transport_stats(pn532_dev_t *dev, pn532_transport_stats_t *stats)
+{
+    if (stats) {
+        *stats = dev->transport_stats;
+    }
+}
+
+void pn532_reset_transport_stats(pn532_dev_t *dev)
+{
+    dev->transport_stats = (pn532_transport_stats_t){ 0 };
+}
+
+void pn532_get_recovery_stats(pn532_dev_t *dev, pn532_recovery_stats_t *stats)
+{
+    if (stats) {
+        *stats = dev->recovery_stats;
+    }
+}
+
+pn532_err_t pn532_get_stats(pn532_dev_t *dev, pn532_stats_t *stats)
+{
+#if PN532_STATS_ENABLE
+    *stats = dev->stats;
+    return PN532_OK;
+#else
+    (void)dev;
+    memset(stats, 0, sizeof(*stats));
+    return PN532_ERR_UNSUPPORTED;
+#endif
+}
+
+void pn532_reset_stats(pn532_dev_t *dev)
+{
+#if PN532_STATS_ENABLE
+    dev->stats = (pn532_stats_t){ 0 };
+    dev->stats_cur.open = false;
+#else
+    (void)dev;
+#endif
 }
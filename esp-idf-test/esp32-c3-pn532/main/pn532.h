@@ -1,5 +1,5 @@
 /**
- * PN532 NFC reader driver for ESP32-C3 (I2C).
+ * PN532 NFC reader driver for ESP32-C3 (I2C, SPI or HSU).
  * Based on TECHNICAL_DOCUMENTATION.md - doc §1, §2, §3, §13.
  */
 
@@ -8,18 +8,46 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* --- Hardware (doc §1) --- */
+/* --- Hardware defaults for PN532_CONFIG_DEFAULT() (doc §1) --- */
+#define PN532_I2C_PORT          0
 #define PN532_I2C_SDA_GPIO      5
 #define PN532_I2C_SCL_GPIO      6
 #define PN532_I2C_FREQ_HZ       100000
 #define PN532_I2C_ADDR_7BIT     0x24
 #define PN532_I2C_ADDR_WRITE   (PN532_I2C_ADDR_7BIT << 1)
 #define PN532_I2C_ADDR_READ    ((PN532_I2C_ADDR_7BIT << 1) | 1)
+#define PN532_IRQ_GPIO          -1      /* PN532 IRQ line (active low); -1 = not wired, poll status byte */
+#define PN532_RST_GPIO          -1      /* PN532 RSTPDN line (active low); -1 = not wired */
+
+/* SPI wiring (doc §1.4); the module must be switched to SPI mode (doc §1.3) */
+#define PN532_TRANSPORT         PN532_TRANSPORT_I2C
+#define PN532_SPI_HOST          1       /* SPI2_HOST, the only general-purpose SPI on the C3 */
+#define PN532_SPI_SCLK_GPIO     4
+#define PN532_SPI_MOSI_GPIO     7
+#define PN532_SPI_MISO_GPIO     2
+#define PN532_SPI_CS_GPIO       10
+#define PN532_SPI_CLOCK_HZ      5000000 /* PN532 maximum */
+
+/* HSU wiring (doc §1.5); PN532 powers up at 115200 8N1 */
+#define PN532_UART_PORT         1
+#define PN532_UART_TX_GPIO      0
+#define PN532_UART_RX_GPIO      1
+#define PN532_UART_BAUD_DEFAULT 115200
+#define PN532_UART_BAUD         921600  /* target for pn532_set_serial_baud_rate() */
+
+/* SPI prefix bytes (doc §7.5), sent LSB first like everything else on this bus */
+#define PN532_SPI_DATA_WRITE    0x01
+#define PN532_SPI_STATUS_READ   0x02
+#define PN532_SPI_DATA_READ     0x03
 
 /* --- Frame constants (doc §2) --- */
 #define PN532_PREAMBLE          0x00
@@ -31,45 +59,174 @@ extern "C" {
 #define PN532_I2C_READY         0x01
 
 /* --- Command / response codes (doc §2) --- */
+#define PN532_CMD_DIAGNOSE              0x00
+#define PN532_RSP_DIAGNOSE              0x01
+#define PN532_DIAG_ATTENTION_REQUEST    0x06  /* ISO14443-4 card presence test */
 #define PN532_CMD_GET_FIRMWARE_VERSION  0x02
 #define PN532_RSP_GET_FIRMWARE_VERSION  0x03
+#define PN532_CMD_SET_SERIAL_BAUD_RATE  0x10
+#define PN532_RSP_SET_SERIAL_BAUD_RATE  0x11
 #define PN532_CMD_SAM_CONFIGURATION     0x14
 #define PN532_RSP_SAM_CONFIGURATION     0x15
 #define PN532_CMD_IN_LIST_PASSIVE_TARGET 0x4A
 #define PN532_RSP_IN_LIST_PASSIVE_TARGET 0x4B
 #define PN532_CMD_IN_RELEASE            0x52
 #define PN532_RSP_IN_RELEASE            0x53
+#define PN532_CMD_IN_DATA_EXCHANGE      0x40
+#define PN532_RSP_IN_DATA_EXCHANGE      0x41
+#define PN532_CMD_IN_AUTO_POLL          0x60
+#define PN532_RSP_IN_AUTO_POLL          0x61
+#define PN532_CMD_RF_CONFIGURATION      0x32
+#define PN532_RSP_RF_CONFIGURATION      0x33
+
+/* --- InListPassiveTarget BrTy (doc §6.4) --- */
 #define PN532_BAUDRATE_106K_ISO14443A    0x00
+#define PN532_BAUDRATE_212K_FELICA       0x01
+#define PN532_BAUDRATE_424K_FELICA       0x02
+#define PN532_BAUDRATE_106K_ISO14443B    0x03
+#define PN532_FELICA_SYSTEM_CODE_ANY     0xFFFF  /* POLLING request wildcard */
+#define PN532_FELICA_IDM_LEN             8
+#define PN532_ISO14443B_PUPI_LEN         4
+
+/* --- InAutoPoll target types (doc §6.6) --- */
+#define PN532_AUTOPOLL_TYPE_GENERIC_106K  0x00  /* Passive 106 kbps ISO14443A / MIFARE / DEP */
+#define PN532_AUTOPOLL_TYPE_MIFARE        0x10  /* MIFARE card */
+#define PN532_AUTOPOLL_TYPE_FELICA_212    0x11
+#define PN532_AUTOPOLL_TYPE_FELICA_424    0x12
+#define PN532_AUTOPOLL_TYPE_ISO14443_4A   0x20
+#define PN532_AUTOPOLL_TYPE_ISO14443_4B   0x23
+#define PN532_AUTOPOLL_MAX_TYPES          15
+#define PN532_AUTOPOLL_ENDLESS            0xFF  /* PollNr: poll until a target appears */
+#define PN532_AUTOPOLL_PERIOD_UNIT_MS     150
+
+/* --- InDataExchange Tg / Status bits (doc §6.7) --- */
+#define PN532_TG_MI                 0x40  /* Tg: host has more data to send */
+#define PN532_STATUS_MI             0x40  /* Status: target has more data, ask again */
+#define PN532_STATUS_ERROR_MASK     0x3F
+
+/* --- ISO14443-4 APDUs / Type 4 tags (doc §10.6) --- */
+#define PN532_APDU_SW_LEN           2
+#define PN532_APDU_MAX_SHORT_LE     256   /* Le byte 0x00 */
+
+/* --- RFConfiguration items (doc §6.9) --- */
+#define PN532_RFCFG_ITEM_RF_FIELD       0x01
+#define PN532_RFCFG_ITEM_TIMINGS        0x02
+#define PN532_RFCFG_ITEM_MAX_RETRIES    0x05
+#define PN532_RFCFG_RF_FIELD_AUTO_RFCA  0x01  /* RF field item: bit 0 */
+#define PN532_RFCFG_RF_FIELD_ON         0x02  /* RF field item: bit 1 */
+#define PN532_RFCFG_RETRY_FOREVER       0xFF
+/* Timing item codes: 0 = no timeout, n = 100 us * 2^(n-1), up to 0x10 (3.28 s) */
+#define PN532_RFCFG_TIMEOUT_MAX_CODE    0x10
+
+/* --- NTAG / MIFARE Ultralight tag commands (doc §10.3) --- */
+#define PN532_NTAG_CMD_READ             0x30
+#define PN532_NTAG_CMD_FAST_READ        0x3A
+#define PN532_NTAG_CMD_WRITE            0xA2
+#define PN532_NTAG_PAGE_SIZE            4
+#define PN532_NTAG_READ_LEN             16    /* READ returns 4 pages */
+#define PN532_NTAG_FAST_READ_MAX_PAGES  (PN532_DATA_EXCHANGE_MAX_LEN / PN532_NTAG_PAGE_SIZE)
+
+/* --- MIFARE Classic tag commands (doc §10.8) --- */
+#define PN532_MIFARE_CMD_AUTH_A         0x60
+#define PN532_MIFARE_CMD_AUTH_B         0x61
+#define PN532_MIFARE_CMD_READ           0x30
+#define PN532_MIFARE_KEY_LEN            6
+#define PN532_MIFARE_BLOCK_SIZE         16
+#define PN532_MIFARE_MAX_SECTOR_BLOCKS  16    /* 4K sectors 32-39; all others have 4 */
+#define PN532_MIFARE_MAX_SECTORS        40    /* Classic 4K */
+#define PN532_MIFARE_KEY_CACHE_LEN      8     /* UIDs whose working keys are remembered */
+#define PN532_MIFARE_KEYS_PER_UID       4     /* Distinct keys remembered per UID */
 
 /* --- Timeouts and delays in ms (doc §3) --- */
 #define PN532_POST_WAKEUP_MS      50
 #define PN532_POST_INIT_MS        100
 #define PN532_RETRY_DELAY_MS      200
-#define PN532_READY_POLL_MS       10
+#define PN532_READY_POLL_MS       10    /* longest sleep between status reads (doc §7.4) */
 #define PN532_ACK_TIMEOUT_MS      100
 #define PN532_RESPONSE_TIMEOUT_MS 1000
 #define PN532_TAG_DETECT_TIMEOUT_MS 150
 #define PN532_I2C_WRITE_TIMEOUT_MS 500
 #define PN532_I2C_READ_TIMEOUT_MS  100
+#define PN532_SPI_TIMEOUT_MS      100
+#define PN532_UART_READ_TIMEOUT_MS 100
+#define PN532_BAUD_SWITCH_MS      10    /* settle time after SetSerialBaudRate (doc §6.8) */
+#define PN532_RESET_PULSE_MS      10
+#define PN532_POST_RESET_MS       10
+
+/*
+ * Bus recovery (doc §15.4): after the bus is freed, wake-up + SAMConfiguration
+ * is tried up to PN532_RECOVER_TRIES times, waiting PN532_RECOVER_WAKEUP_MS
+ * after the first wake-up and twice as long after each further one (10 + 20
+ * + 40 + 80 ms rides out a brown-out of ~150 ms). If that fails and RSTPDN is
+ * wired, the chip is hard reset and it is tried again.
+ */
+#define PN532_RECOVER_TRIES       4
+#define PN532_RECOVER_WAKEUP_MS   10
+
+/*
+ * Ready wait without IRQ (doc §7.4): status reads PN532_READY_SPIN_US apart
+ * until the frame is expected, then with doubling gaps. Busy waiting ends
+ * PN532_READY_SPIN_MAX_US into the wait (at once if the frame is expected
+ * later than that); then the task sleeps 1, 2, 4 ... ticks, at most
+ * PN532_READY_POLL_MS.
+ */
+#define PN532_READY_SPIN_US       100
+#define PN532_READY_SPIN_MAX_US   8000
 
-#define PN532_POLL_INTERVAL_MS    250
+#define PN532_POLL_INTERVAL_MS    250   /* AutoPoll pause, error back-off (doc §12.6) */
 #define PN532_DEBOUNCE_MS         1000
 #define PN532_REMOVAL_THRESHOLD   3
 
 #define PN532_MAX_UID_LEN         10
+#define PN532_MAX_TARGETS         2     /* InListPassiveTarget MaxTg limit (doc §6.4) */
 #define PN532_RESPONSE_BUFFER_LEN 64
 
+/*
+ * Largest LEN (TFI + data) the PN532 takes or sends in one frame; above 255
+ * both directions use extended frames, 00 00 FF FF FF LENM LENL LCS (doc §4.4).
+ */
+#define PN532_FRAME_MAX_DATA      264
+/*
+ * Largest frame as read from the bus: ready + preamble + 00 FF + FF FF
+ * + LENM/LENL/LCS + LEN + DCS + postamble (doc §4.3, §4.4).
+ */
+#define PN532_FRAME_MAX_LEN       (1 + 3 + 5 + PN532_FRAME_MAX_DATA + 2)
+/* InDataExchange payload per frame: LEN minus TFI, command/response code, Tg/Status */
+#define PN532_DATA_EXCHANGE_MAX_LEN (PN532_FRAME_MAX_DATA - 3)
+
+/*
+ * Two-phase response read (doc §8.3): read ready + header (8 bytes, enough for
+ * an extended-frame LEN), then only the exact frame. 0 = one fixed 64-byte read.
+ */
+#define PN532_TWO_PHASE_READ        1
+#define PN532_FRAME_HEADER_READ_LEN 8
+
+/*
+ * Command statistics (doc §15.3): per-command latency histograms split by
+ * phase, and a counter per pn532_err_t. 0 compiles the hooks out entirely.
+ * Histogram bucket k counts exchanges under PN532_STATS_BUCKET0_US << k;
+ * the last bucket is open-ended (>= 128 ms with the defaults).
+ */
+#define PN532_STATS_ENABLE          1
+#define PN532_STATS_COMMANDS        16    /* Command codes tracked per reader */
+#define PN532_STATS_BUCKETS         10
+#define PN532_STATS_BUCKET0_US      500
+
 /* --- Return codes --- */
 typedef enum {
     PN532_OK = 0,
     PN532_ERR_TIMEOUT,
-    PN532_ERR_I2C,
+    PN532_ERR_I2C,         /* Bus transaction failed (any transport) */
     PN532_ERR_ACK,
     PN532_ERR_CHECKSUM,
     PN532_ERR_PARSE,
     PN532_ERR_RESPONSE,
     PN532_ERR_SIZE,
     PN532_ERR_NOT_FOUND,   /* No tag present (normal) */
+    PN532_ERR_TARGET,      /* PN532 reported an RF/target error in the status byte */
+    PN532_ERR_BUSY,        /* An asynchronous command is still in flight */
+    PN532_ERR_UNSUPPORTED, /* Operation not available for this tag type */
+    PN532_ERR_COUNT,       /* Number of codes, not a result */
 } pn532_err_t;
 
 /* --- Tag type from SAK (doc §11) --- */
@@ -81,6 +238,8 @@ typedef enum {
     PN532_TAG_MIFARE_CLASSIC_4K,
     PN532_TAG_MIFARE_PLUS,
     PN532_TAG_MIFARE_DESFIRE,
+    PN532_TAG_FELICA,            /* uid holds the 8-byte IDm (NFCID2) */
+    PN532_TAG_ISO14443B,         /* uid holds the 4-byte PUPI; ISO-DEP after ATTRIB */
 } pn532_tag_type_t;
 
 /* --- Data structures (doc §13) --- */
@@ -97,46 +256,555 @@ typedef struct {
     uint8_t sak;
     uint8_t atqa[2];
     pn532_tag_type_t type;
+    uint8_t tg;      /* Logical target number assigned by the PN532 (1 or 2) */
+    uint8_t brty;    /* PN532_BAUDRATE_* it was found with; sak/atqa only set for 106A */
 } pn532_tag_info_t;
 
+/* InAutoPoll parameters (doc §6.6) */
+typedef struct {
+    uint8_t poll_nr;     /* 0x01..0xFE polls per type, or PN532_AUTOPOLL_ENDLESS */
+    uint8_t period;      /* 0x01..0x0F, units of PN532_AUTOPOLL_PERIOD_UNIT_MS */
+    uint8_t type_count;  /* 1..PN532_AUTOPOLL_MAX_TYPES */
+    uint8_t types[PN532_AUTOPOLL_MAX_TYPES];
+} pn532_autopoll_config_t;
+
+/* Ready waits with their own learned latency (doc §7.4) */
+typedef enum {
+    PN532_HINT_ACK,        /* Command -> ACK, and a NACK re-send */
+    PN532_HINT_LOCAL,      /* Answered without RF, e.g. GetFirmwareVersion */
+    PN532_HINT_LIST,       /* InListPassiveTarget */
+    PN532_HINT_EXCHANGE,   /* InDataExchange, Diagnose presence probe */
+    PN532_HINT_AUTOPOLL,   /* InAutoPoll: longer than any spin */
+    PN532_HINT_COUNT,
+} pn532_ready_hint_t;
+
+/* Asynchronous command states (doc §8.4) */
+typedef enum {
+    PN532_ASYNC_IDLE,      /* No command in flight */
+    PN532_ASYNC_SENT,      /* Frame written, waiting for ACK */
+    PN532_ASYNC_ACKED,     /* ACK read, waiting for response */
+    PN532_ASYNC_NACKED,    /* Two-phase read: header read and NACK sent, waiting for the re-sent frame */
+    PN532_ASYNC_RECEIVING, /* Stream bus (HSU): header read, waiting for the rest to be buffered */
+    PN532_ASYNC_RESPONSE,  /* Response being read and delivered */
+} pn532_async_state_t;
+
+/*
+ * Completion callback, run from pn532_process(). data holds the response
+ * (response code first) and is only valid during the call; NULL on error.
+ */
+typedef void (*pn532_async_cb_t)(pn532_err_t err, const uint8_t *data, size_t len, void *ctx);
+
+/* Per-transaction bus timing (one I2C/SPI read or write each) */
+typedef struct {
+    uint32_t transactions;
+    uint32_t errors;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t last_us;
+} pn532_transport_stats_t;
+
+/* pn532_recover() runs (doc §15.4); times cover the whole procedure */
+typedef struct {
+    uint32_t attempts;
+    uint32_t failures;
+    uint32_t hard_resets;
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t last_us;
+} pn532_recovery_stats_t;
+
+/* Where a command's time goes (doc §15.3) */
+typedef enum {
+    PN532_PHASE_WRITE,     /* Command frame on the bus */
+    PN532_PHASE_ACK,       /* Ready wait and ACK read */
+    PN532_PHASE_WAIT,      /* Ready wait for the response: PN532 and RF time */
+    PN532_PHASE_READ,      /* Response read (NACK re-send included) and checks */
+    PN532_PHASE_COUNT,
+} pn532_phase_t;
+
+/* One command code; hist covers the whole exchange, send to response */
+typedef struct {
+    uint8_t command;     /* PN532_CMD_*; slot free while count == 0 */
+    uint32_t count;
+    uint32_t errors;
+    uint32_t max_us;
+    uint32_t hist[PN532_STATS_BUCKETS];
+    uint64_t phase_total_us[PN532_PHASE_COUNT];
+    uint32_t phase_max_us[PN532_PHASE_COUNT];
+} pn532_command_stats_t;
+
+typedef struct {
+    pn532_command_stats_t commands[PN532_STATS_COMMANDS];
+    uint32_t results[PN532_ERR_COUNT];   /* Exchanges by outcome; [PN532_OK] = successes */
+    uint32_t untracked;                  /* Exchanges of commands with no free slot */
+} pn532_stats_t;
+
+/* One MIFARE Classic key and which of the sector's two keys it is */
+typedef struct {
+    uint8_t auth_cmd;                    /* PN532_MIFARE_CMD_AUTH_A or _AUTH_B */
+    uint8_t key[PN532_MIFARE_KEY_LEN];
+} pn532_mifare_key_t;
+
+/*
+ * One card in a reader's key cache (doc §10.8): the distinct keys that opened
+ * its sectors, and which of them opens each sector. A card seldom uses more
+ * than two keys (MAD key A for sector 0, D3F7 for the NDEF sectors), so keys
+ * are stored once, not per sector. Only pn532_mifare.c touches these.
+ */
+typedef struct {
+    bool used;
+    uint8_t uid[PN532_MAX_UID_LEN];
+    uint8_t uid_len;
+    uint32_t last_use;   /* LRU stamp from the cache's clock */
+    uint8_t key_count;
+    uint8_t next_key;    /* Slot recycled when all PN532_MIFARE_KEYS_PER_UID are taken */
+    pn532_mifare_key_t keys[PN532_MIFARE_KEYS_PER_UID];
+    uint8_t sector_key[PN532_MIFARE_MAX_SECTORS];   /* Index into keys, 0xFF if not known yet */
+} pn532_mifare_key_entry_t;
+
+/* Outcome of pn532_ntag_write_pages() */
+typedef struct {
+    unsigned pages;        /* pages the tag accepted */
+    uint32_t write_us;     /* WRITE phase */
+    uint32_t verify_us;    /* FAST_READ verify phase, 0 if not requested */
+    uint32_t pages_per_s;  /* pages / (write_us + verify_us) */
+} pn532_ntag_write_result_t;
+
+/* I2C transport settings (doc §1.2) */
+typedef struct {
+    int port;
+    int sda_gpio;
+    int scl_gpio;
+    uint32_t freq_hz;    /* 100 kHz default; the PN532 supports up to 400 kHz */
+    uint8_t addr_7bit;
+} pn532_i2c_config_t;
+
+/* SPI transport settings (doc §1.4) */
+typedef struct {
+    int host;            /* spi_host_device_t */
+    int sclk_gpio;
+    int mosi_gpio;
+    int miso_gpio;
+    int cs_gpio;
+    uint32_t clock_hz;
+} pn532_spi_config_t;
+
+/* HSU transport settings (doc §1.5) */
+typedef struct {
+    int port;            /* uart_port_t; one PN532 per UART */
+    int tx_gpio;
+    int rx_gpio;
+    uint32_t baud;       /* rate nfc_init() escalates to; the link starts at 115200 */
+} pn532_uart_config_t;
+
+/* Host interface; must match the I0/I1 strapping of the board (doc §1.3) */
+typedef enum {
+    PN532_TRANSPORT_I2C = 0,
+    PN532_TRANSPORT_SPI,
+    PN532_TRANSPORT_HSU,
+} pn532_transport_t;
+
+/* Per-reader configuration */
+typedef struct {
+    pn532_transport_t transport;
+    pn532_i2c_config_t i2c;
+    pn532_spi_config_t spi;
+    pn532_uart_config_t uart;
+    int irq_gpio;        /* -1 = not wired, poll status byte */
+    int rst_gpio;        /* -1 = not wired */
+} pn532_config_t;
+
+#define PN532_CONFIG_DEFAULT() {                  \
+    .transport = PN532_TRANSPORT,                 \
+    .i2c = {                                      \
+        .port      = PN532_I2C_PORT,              \
+        .sda_gpio  = PN532_I2C_SDA_GPIO,          \
+        .scl_gpio  = PN532_I2C_SCL_GPIO,          \
+        .freq_hz   = PN532_I2C_FREQ_HZ,           \
+        .addr_7bit = PN532_I2C_ADDR_7BIT,         \
+    },                                            \
+    .spi = {                                      \
+        .host      = PN532_SPI_HOST,              \
+        .sclk_gpio = PN532_SPI_SCLK_GPIO,         \
+        .mosi_gpio = PN532_SPI_MOSI_GPIO,         \
+        .miso_gpio = PN532_SPI_MISO_GPIO,         \
+        .cs_gpio   = PN532_SPI_CS_GPIO,           \
+        .clock_hz  = PN532_SPI_CLOCK_HZ,          \
+    },                                            \
+    .uart = {                                     \
+        .port      = PN532_UART_PORT,             \
+        .tx_gpio   = PN532_UART_TX_GPIO,          \
+        .rx_gpio   = PN532_UART_RX_GPIO,          \
+        .baud      = PN532_UART_BAUD,             \
+    },                                            \
+    .irq_gpio = PN532_IRQ_GPIO,                   \
+    .rst_gpio = PN532_RST_GPIO,                   \
+}
+
+/*
+ * One PN532 reader. Allocate it (static or on a long-lived stack) and pass it
+ * to pn532_init(); fields are owned by the driver. Each reader has its own
+ * IRQ semaphore, async state and counters, so several can run side by side.
+ */
+struct pn532_transport_ops;
+
+typedef struct pn532_dev {
+    pn532_config_t config;
+    bool initialized;
+
+    /* Bus backend picked from config.transport at init (pn532_transport.h) */
+    const struct pn532_transport_ops *transport;
+    void *bus_handle;    /* backend-private, e.g. the spi_device_handle_t */
+    uint32_t bus_baud;   /* current HSU rate; 0 on other buses */
+
+    /* Given from the IRQ falling edge; NULL when polling the status byte */
+    SemaphoreHandle_t irq_sem;
+    StaticSemaphore_t irq_sem_buf;
+    /* Task notified on IRQ so it can call pn532_process() (async API) */
+    volatile TaskHandle_t notify_task;
+
+    pn532_transport_stats_t transport_stats;
+    pn532_recovery_stats_t recovery_stats;
+    /* Expected time to ready per wait class, and the class of the pending response */
+    uint32_t ready_hint_us[PN532_HINT_COUNT];
+    pn532_ready_hint_t response_hint;
+
+#if PN532_STATS_ENABLE
+    pn532_stats_t stats;
+    /* Exchange in progress: opened by send_command(), closed by read_response() */
+    struct {
+        bool open;
+        uint8_t command;
+        int64_t start_us;
+        int64_t mark_us;
+        uint32_t phase_us[PN532_PHASE_COUNT];
+    } stats_cur;
+#endif
+
+    /*
+     * Raw frame of the response being read (doc §8.3). Kept here rather than
+     * on the caller's stack, so the polling task does not need room for a
+     * 275-byte frame at every level of a tag read.
+     */
+    uint8_t frame[PN532_FRAME_MAX_LEN];
+
+    /*
+     * Keys that opened MIFARE Classic sectors on cards seen by this reader
+     * (doc §10.8). Per reader, so two stations never share or clear each
+     * other's entries; like the rest of the device, one task uses it.
+     */
+    struct {
+        pn532_mifare_key_entry_t cards[PN532_MIFARE_KEY_CACHE_LEN];
+        uint32_t clock;
+    } mifare_keys;
+
+    /* Asynchronous command in flight (doc §8.4) */
+    struct {
+        pn532_async_state_t state;
+        pn532_async_cb_t cb;
+        void *ctx;
+        int64_t deadline_us;
+        uint32_t response_timeout_ms;
+        size_t frame_len;            /* NACKED, RECEIVING: length of the frame being read */
+        size_t frame_have;           /* RECEIVING: bytes of it already in frame[] */
+        uint8_t rx[PN532_FRAME_MAX_LEN];
+    } async;
+} pn532_dev_t;
+
+/**
+ * Set up the bus for this reader, the optional IRQ line, and pulse RSTPDN if
+ * wired. Does NOT send wake-up; caller does init sequence. Readers sharing an
+ * I2C port or SPI host share the installed driver (the first reader's pins
+ * and I2C clock win); SPI readers each get their own CS.
+ */
+pn532_err_t pn532_init(pn532_dev_t *dev, const pn532_config_t *config);
+
+/**
+ * Switch the HSU link to baud (doc §6.8): 9600 ... 921600 or 1288000. The PN532
+ * changes rate after the host ACKs the response; the new rate is then checked
+ * with GetFirmwareVersion and the host falls back to the old one on failure.
+ * Returns PN532_ERR_UNSUPPORTED on I2C/SPI or for a rate the PN532 lacks.
+ */
+pn532_err_t pn532_set_serial_baud_rate(pn532_dev_t *dev, uint32_t baud);
+
 /**
- * Initialize I2C and PN532. Does NOT send wake-up; caller does init sequence.
- * Returns PN532_OK if I2C master is installed (or already existed).
+ * Hard reset via RSTPDN (needs rst_gpio). Caller re-runs wake-up and SAM config.
  */
-pn532_err_t pn532_init(void);
+pn532_err_t pn532_hard_reset(pn532_dev_t *dev);
+
+/**
+ * Bring a reader back after bus errors (doc §15.4): drop any async command,
+ * let the transport free the bus and reset its controller (I2C: 9 SCL pulses,
+ * STOP, driver re-install), then wake-up + SAMConfiguration, falling back to
+ * a hard reset when RSTPDN is wired. RFConfiguration is back at chip defaults
+ * if the PN532 lost power, so the caller re-applies its own settings.
+ */
+pn532_err_t pn532_recover(pn532_dev_t *dev);
 
 /**
  * Send wake-up sequence (doc §6.1). Ignore NACK. Caller must delay 50ms after.
  */
-void pn532_wakeup(void);
+void pn532_wakeup(pn532_dev_t *dev);
 
 /**
  * Get firmware version (doc §6.2, §9.2). Fills *version on success.
  */
-pn532_err_t pn532_get_firmware_version(pn532_firmware_version_t *version);
+pn532_err_t pn532_get_firmware_version(pn532_dev_t *dev, pn532_firmware_version_t *version);
 
 /**
  * Configure SAM (doc §6.3, §9.3). Must be called before tag detection.
  */
-pn532_err_t pn532_sam_config(void);
+pn532_err_t pn532_sam_config(pn532_dev_t *dev);
+
+/**
+ * Switch the RF field (RFConfiguration item 1, doc §6.9). Turning it off
+ * between polls saves power; the next InListPassiveTarget turns it back on.
+ */
+pn532_err_t pn532_set_rf_field(pn532_dev_t *dev, bool on);
+
+/**
+ * Timeouts (RFConfiguration item 2): ATR_RES wait (DEP activation) and
+ * InCommunicateThru/InDataExchange wait for non-DEP targets. Codes per
+ * PN532_RFCFG_TIMEOUT_MAX_CODE; chip defaults are 0x0B (102.4 ms) and 0x0A.
+ */
+pn532_err_t pn532_set_rf_timings(pn532_dev_t *dev, uint8_t atr_res_timeout, uint8_t retry_timeout);
+
+/**
+ * Retry counts (RFConfiguration item 5). passive_activation bounds how often
+ * InListPassiveTarget tries to activate a target; the chip default 0xFF
+ * (PN532_RFCFG_RETRY_FOREVER) makes an empty field wait for the host timeout.
+ * 0x00 = one attempt. Chip defaults: atr 0xFF, psl 0x01, passive 0xFF.
+ */
+pn532_err_t pn532_set_max_retries(pn532_dev_t *dev, uint8_t atr, uint8_t psl,
+                                  uint8_t passive_activation);
 
 /**
  * Detect one passive target ISO14443A (doc §6.4, §10.1).
  * timeout_ms: e.g. PN532_TAG_DETECT_TIMEOUT_MS (150).
  * Returns PN532_ERR_NOT_FOUND / PN532_ERR_TIMEOUT when no tag (normal).
  */
-pn532_err_t pn532_read_passive_target(uint32_t timeout_ms, pn532_tag_info_t *tag);
+pn532_err_t pn532_read_passive_target(pn532_dev_t *dev, uint32_t timeout_ms, pn532_tag_info_t *tag);
+
+/**
+ * Detect one passive target with modulation brty (PN532_BAUDRATE_*, doc §6.4):
+ * 106A as above, 106B with AFI 0 (all families), FeliCa 212/424 with a
+ * POLLING request for any system code. Same return codes as
+ * pn532_read_passive_target(); PN532_ERR_UNSUPPORTED for other BrTy values.
+ */
+pn532_err_t pn532_list_passive_target(pn532_dev_t *dev, uint8_t brty, uint32_t timeout_ms,
+                                      pn532_tag_info_t *tag);
+
+/**
+ * Activate the card with tag's UID again (InListPassiveTarget with the UID
+ * as InitiatorData, doc §6.4) and update tag->tg. Needed after a failed
+ * MIFARE authentication, which drops the card back to IDLE (doc §10.8).
+ * Returns PN532_ERR_NOT_FOUND if that card no longer answers.
+ */
+pn532_err_t pn532_reselect_target(pn532_dev_t *dev, pn532_tag_info_t *tag);
+
+/**
+ * Detect up to max_tags (1..PN532_MAX_TARGETS) ISO14443A targets in a single
+ * InListPassiveTarget round trip (MaxTg=2, doc §6.4). Fills tags[0..*count-1];
+ * each entry's tg identifies it for later commands. Returns PN532_ERR_NOT_FOUND
+ * when the field is empty.
+ */
+pn532_err_t pn532_inventory(pn532_dev_t *dev, uint32_t timeout_ms, pn532_tag_info_t *tags,
+                            unsigned max_tags, unsigned *count);
+
+/**
+ * Exchange data with an activated target (InDataExchange, doc §6.7).
+ * tx is sent to target tg; the target's reply (after the status byte) is
+ * copied to rx. Returns PN532_ERR_TARGET when the status byte reports an error
+ * and PN532_ERR_SIZE if the reply is MI-chained (see below).
+ */
+pn532_err_t pn532_data_exchange(pn532_dev_t *dev, uint8_t tg, const uint8_t *tx, size_t tx_len,
+                                uint8_t *rx, size_t rx_max, size_t *rx_len);
+
+/**
+ * pn532_data_exchange() that also returns the raw Status byte, so callers can
+ * drive MI chaining (doc §6.7): set PN532_TG_MI in tg while more command data
+ * follows, and call again with no tx while *status has PN532_STATUS_MI.
+ */
+pn532_err_t pn532_data_exchange_status(pn532_dev_t *dev, uint8_t tg, const uint8_t *tx, size_t tx_len,
+                                       uint8_t *rx, size_t rx_max, size_t *rx_len, uint8_t *status);
+
+/**
+ * NTAG/Ultralight READ (0x30): 16 bytes (4 pages) from page in one round trip (doc §10.3).
+ */
+pn532_err_t pn532_ntag_read(pn532_dev_t *dev, uint8_t tg, uint8_t page, uint8_t out[PN532_NTAG_READ_LEN]);
+
+/**
+ * NTAG FAST_READ (0x3A): pages start_page..end_page inclusive into out.
+ * Split into PN532_NTAG_FAST_READ_MAX_PAGES chunks to fit one frame (doc §10.3).
+ */
+pn532_err_t pn532_ntag_fast_read(pn532_dev_t *dev, uint8_t tg, uint8_t start_page, uint8_t end_page,
+                                 uint8_t *out, size_t out_max);
+
+/**
+ * NTAG/Ultralight WRITE (0xA2) of page_count pages from data, starting at
+ * start_page, one InDataExchange per page on the already selected target
+ * (doc §10.7). With verify, the range is read back with FAST_READ once at the
+ * end rather than after every page. Returns PN532_ERR_TARGET if the tag NAKs
+ * a page (locked or out of range) or the read-back differs; result (may be
+ * NULL) then holds the pages written so far. Pages 0-3 hold UID, lock bytes
+ * and CC: writing them is allowed but usually permanent.
+ */
+pn532_err_t pn532_ntag_write_pages(pn532_dev_t *dev, uint8_t tg, uint8_t start_page, const uint8_t *data,
+                                   unsigned page_count, bool verify, pn532_ntag_write_result_t *result);
+
+/**
+ * MIFARE Classic authentication (0x60/0x61) of block's sector with key
+ * (doc §10.8). Uses the last 4 UID bytes, as the card does for 7-byte UIDs.
+ * PN532_ERR_TARGET means the key was wrong; the card is then IDLE and must
+ * be re-activated with pn532_reselect_target() before the next attempt.
+ */
+pn532_err_t pn532_mifare_auth(pn532_dev_t *dev, const pn532_tag_info_t *tag, uint8_t block,
+                              const pn532_mifare_key_t *key);
+
+/**
+ * MIFARE Classic READ (0x30) of one 16-byte block in the authenticated sector.
+ */
+pn532_err_t pn532_mifare_read_block(pn532_dev_t *dev, uint8_t tg, uint8_t block,
+                                    uint8_t out[PN532_MIFARE_BLOCK_SIZE]);
+
+/**
+ * Authenticate sector once and read all its blocks, trailer included, into
+ * out (4 or 16 blocks of PN532_MIFARE_BLOCK_SIZE; *out_len set). The key
+ * that last opened this sector of this UID is tried first, then the card's
+ * other cached keys, then keys[0..key_count-1];
+ * the card is re-activated after each failed attempt, so tag->tg may change.
+ * Returns PN532_ERR_TARGET if no key opens the sector, PN532_ERR_UNSUPPORTED
+ * if tag is not a Classic 1K/4K or sector is out of range.
+ */
+pn532_err_t pn532_mifare_read_sector(pn532_dev_t *dev, pn532_tag_info_t *tag, uint8_t sector,
+                                     const pn532_mifare_key_t *keys, unsigned key_count,
+                                     uint8_t *out, size_t out_max, size_t *out_len);
+
+/**
+ * Forget every key this reader remembers, e.g. after the key list changed.
+ * Other readers keep their own caches.
+ */
+void pn532_mifare_key_cache_clear(pn532_dev_t *dev);
+
+/**
+ * Exchange one APDU with an ISO14443-4 target (doc §10.6). Long command APDUs
+ * go out in MI-chained pieces; MI-chained response pieces are written straight
+ * into rapdu one after another. rapdu receives the data plus SW1 SW2.
+ */
+pn532_err_t pn532_apdu_exchange(pn532_dev_t *dev, uint8_t tg, const uint8_t *capdu, size_t capdu_len,
+                                uint8_t *rapdu, size_t rapdu_max, size_t *rapdu_len);
+
+/**
+ * Read the NDEF message of an NFC Forum Type 4 tag (doc §10.6): select the
+ * NDEF application and CC file, read the CC, select the NDEF file and read it
+ * with READ BINARY at the largest Le the tag allows. The message (without
+ * NLEN) lands directly in out. Returns PN532_ERR_TARGET if the tag rejects a
+ * step (e.g. no NDEF application), PN532_ERR_SIZE if it exceeds out_max.
+ */
+pn532_err_t pn532_type4_read_ndef(pn532_dev_t *dev, uint8_t tg, uint8_t *out, size_t out_max,
+                                  size_t *out_len);
+
+/**
+ * True if pn532_target_present() has a cheap probe for this tag:
+ * NTAG/Ultralight (READ page 0) and ISO14443-4 A/B targets (Diagnose 0x06).
+ */
+bool pn532_presence_check_supported(const pn532_tag_info_t *tag);
+
+/**
+ * Check that the still-selected tag is in the field without releasing and
+ * re-listing it (doc §10.5). Returns PN532_OK if present, PN532_ERR_NOT_FOUND
+ * if it stopped answering, PN532_ERR_UNSUPPORTED for e.g. MIFARE Classic.
+ */
+pn532_err_t pn532_target_present(pn532_dev_t *dev, const pn532_tag_info_t *tag);
 
 /**
  * Release activated tag (doc §6.5, §10.2).
  */
-pn532_err_t pn532_release_target(void);
+pn532_err_t pn532_release_target(pn532_dev_t *dev);
+
+/**
+ * Start autonomous polling (InAutoPoll, doc §6.6). Returns once the command
+ * is ACKed; the PN532 then polls the configured types on its own.
+ */
+pn532_err_t pn532_start_autopoll(pn532_dev_t *dev, const pn532_autopoll_config_t *config);
+
+/**
+ * Wait for the InAutoPoll result. With an IRQ line wired the host sleeps
+ * until the PN532 has a target. Fills tag from the first record of a type the
+ * driver parses: 106 kbps type A (0x00, 0x10, 0x20), FeliCa (0x11, 0x12) or
+ * ISO14443-4B (0x23). Returns PN532_ERR_TIMEOUT while still polling,
+ * PN532_ERR_NOT_FOUND when PollNr ran out (NbTg = 0) or every record is of
+ * another type, e.g. a DEP or Jewel target.
+ */
+pn532_err_t pn532_autopoll_wait(pn532_dev_t *dev, uint32_t timeout_ms, pn532_tag_info_t *tag);
+
+/**
+ * Abort a running InAutoPoll by sending an ACK frame.
+ */
+pn532_err_t pn532_stop_autopoll(pn532_dev_t *dev);
 
 /**
  * Derive tag type from SAK and UID length (doc §11.2).
  */
 pn532_tag_type_t pn532_determine_tag_type(uint8_t sak, uint8_t uid_length);
 
+/**
+ * Start a command without blocking (doc §8.4): writes the frame and returns.
+ * Advance with pn532_process(); cb runs once the response arrives or the
+ * ACK/response timeout expires. Blocking calls return PN532_ERR_BUSY meanwhile.
+ */
+pn532_err_t pn532_submit(pn532_dev_t *dev, uint8_t command, const uint8_t *params, unsigned param_count,
+                         uint32_t timeout_ms, pn532_async_cb_t cb, void *ctx);
+
+/**
+ * Advance the in-flight command by at most one step without blocking on the
+ * PN532. Call on IRQ notification (see pn532_set_notify_task) or from a
+ * periodic timer/loop. Returns the state after the step. On HSU a step only
+ * reads bytes already in the UART buffer, so the frame is taken in two steps
+ * (header, then the rest once it has all arrived).
+ */
+pn532_async_state_t pn532_process(pn532_dev_t *dev);
+
+/**
+ * Abort the in-flight command (an ACK frame cancels it on the PN532). No callback.
+ */
+void pn532_cancel(pn532_dev_t *dev);
+
+/**
+ * Task to receive a FreeRTOS task notification on every IRQ edge, so a
+ * cooperative loop can sleep in ulTaskNotifyTake() and call pn532_process().
+ * NULL to disable. Only effective when PN532_IRQ_GPIO is wired.
+ */
+void pn532_set_notify_task(pn532_dev_t *dev, TaskHandle_t task);
+
+/**
+ * Copy transport timing counters; mean = total_us / transactions.
+ */
+void pn532_get_transport_stats(pn532_dev_t *dev, pn532_transport_stats_t *stats);
+
+/**
+ * Zero transport timing counters.
+ */
+void pn532_reset_transport_stats(pn532_dev_t *dev);
+
+/**
+ * Copy the pn532_recover() counters; mean = total_us / attempts.
+ */
+void pn532_get_recovery_stats(pn532_dev_t *dev, pn532_recovery_stats_t *stats);
+
+/**
+ * Copy the command statistics (doc §15.3). Only synchronous exchanges are
+ * counted; the outcome is that of the frame exchange, before the caller
+ * interprets the response. PN532_ERR_UNSUPPORTED (and stats zeroed) when
+ * built with PN532_STATS_ENABLE 0.
+ */
+pn532_err_t pn532_get_stats(pn532_dev_t *dev, pn532_stats_t *stats);
+
+/**
+ * Zero the command statistics.
+ */
+void pn532_reset_stats(pn532_dev_t *dev);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,178 @@
+/**
+ * PN532 HSU (high-speed UART) transport (doc §1.5, §7.6).
+ * The link starts at the PN532 power-on rate of 115200 8N1;
+ * pn532_set_serial_baud_rate() raises it afterwards. HSU has no ready byte or
+ * status read: the PN532 simply sends the frame, so "ready" means bytes in the
+ * RX buffer, and waiting blocks on the UART driver's event queue.
+ */
+
+#include "pn532_transport.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+static const char *TAG = "pn532_hsu";
+
+#define HSU_READ_TICKS      pdMS_TO_TICKS(PN532_UART_READ_TIMEOUT_MS)
+#define HSU_WRITE_TICKS     pdMS_TO_TICKS(PN532_I2C_WRITE_TIMEOUT_MS)
+/* Room for a full frame plus the ACK queued ahead of it */
+#define HSU_RX_BUF_LEN      (2 * PN532_FRAME_MAX_LEN)
+#define HSU_EVENT_QUEUE_LEN 8
+/* Post UART_DATA after 2 idle symbols instead of the default 10 */
+#define HSU_RX_TOUT_SYMBOLS 2
+
+static uart_port_t port_of(pn532_dev_t *dev)
+{
+    return (uart_port_t)dev->config.uart.port;
+}
+
+/* Drop everything received so far, including queued events for it */
+static void hsu_discard_input(pn532_dev_t *dev)
+{
+    uart_flush_input(port_of(dev));
+    xQueueReset((QueueHandle_t)dev->bus_handle);
+}
+
+/* Called from pn532_init() only; one PN532 per UART */
+static pn532_err_t hsu_init(pn532_dev_t *dev)
+{
+    const pn532_uart_config_t *cfg = &dev->config.uart;
+    if (dev->bus_handle) {
+        return PN532_OK;
+    }
+    if (cfg->port < 0 || cfg->port >= UART_NUM_MAX) {
+        ESP_LOGE(TAG, "invalid UART port %d", cfg->port);
+        return PN532_ERR_I2C;
+    }
+
+    uart_config_t conf = {
+        .baud_rate  = PN532_UART_BAUD_DEFAULT,
+        .data_bits  = UART_DATA_8_BITS,
+        .parity     = UART_PARITY_DISABLE,
+        .stop_bits  = UART_STOP_BITS_1,
+        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    esp_err_t ret = uart_param_config(cfg->port, &conf);
+    if (ret == ESP_OK) {
+        ret = uart_set_pin(cfg->port, cfg->tx_gpio, cfg->rx_gpio,
+                           UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "UART config failed %d", ret);
+        return PN532_ERR_I2C;
+    }
+
+    QueueHandle_t events;
+    ret = uart_driver_install(cfg->port, HSU_RX_BUF_LEN, 0, HSU_EVENT_QUEUE_LEN, &events, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "uart_driver_install failed %d", ret);
+        return PN532_ERR_I2C;
+    }
+    (void)uart_set_rx_timeout(cfg->port, HSU_RX_TOUT_SYMBOLS);
+    dev->bus_handle = events;
+    dev->bus_baud = PN532_UART_BAUD_DEFAULT;
+    return PN532_OK;
+}
+
+/* A new command makes anything still buffered stale, so drop it first */
+static pn532_err_t hsu_writev(pn532_dev_t *dev, const pn532_iovec_t *iov, unsigned iovcnt)
+{
+    int64_t start = esp_timer_get_time();
+    hsu_discard_input(dev);
+    bool ok = true;
+    for (unsigned k = 0; k < iovcnt && ok; k++) {
+        ok = uart_write_bytes(port_of(dev), iov[k].data, iov[k].len) == (int)iov[k].len;
+    }
+    pn532_transport_record(dev, start, ok);
+    return ok ? PN532_OK : PN532_ERR_I2C;
+}
+
+static pn532_err_t hsu_read_continue(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    if (len == 0) {
+        return PN532_OK;
+    }
+    int64_t start = esp_timer_get_time();
+    int n = uart_read_bytes(port_of(dev), buf, (uint32_t)len, HSU_READ_TICKS);
+    bool ok = (n == (int)len);
+    pn532_transport_record(dev, start, ok);
+    return ok ? PN532_OK : PN532_ERR_TIMEOUT;
+}
+
+/* Same layout as I2C: synthetic ready byte, then len - 1 received bytes */
+static pn532_err_t hsu_read(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    if (len == 0) {
+        return PN532_OK;
+    }
+    buf[0] = PN532_I2C_READY;
+    return hsu_read_continue(dev, buf + 1, len - 1);
+}
+
+static size_t hsu_buffered(pn532_dev_t *dev)
+{
+    size_t buffered = 0;
+    if (uart_get_buffered_data_len(port_of(dev), &buffered) != ESP_OK) {
+        return 0;
+    }
+    return buffered;
+}
+
+static bool hsu_is_ready(pn532_dev_t *dev)
+{
+    return hsu_buffered(dev) > 0;
+}
+
+/*
+ * Block on the UART event queue. Buffered data is checked before each wait,
+ * as in wait_ready_irq(), so bytes that arrived earlier are never missed.
+ * On overflow the frame is lost either way; flush and let the caller time out.
+ */
+static pn532_err_t hsu_wait_ready(pn532_dev_t *dev, uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+
+    for (;;) {
+        if (hsu_is_ready(dev)) {
+            return PN532_OK;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            return PN532_ERR_TIMEOUT;
+        }
+        uart_event_t ev;
+        if (xQueueReceive((QueueHandle_t)dev->bus_handle, &ev, timeout - elapsed) == pdTRUE &&
+            (ev.type == UART_FIFO_OVF || ev.type == UART_BUFFER_FULL)) {
+            ESP_LOGW(TAG, "RX overflow, frame dropped");
+            hsu_discard_input(dev);
+        }
+    }
+}
+
+/* Let the last frame (the ACK that triggers the PN532's switch) leave at the old rate */
+static pn532_err_t hsu_set_baud(pn532_dev_t *dev, uint32_t baud)
+{
+    if (uart_wait_tx_done(port_of(dev), HSU_WRITE_TICKS) != ESP_OK ||
+        uart_set_baudrate(port_of(dev), baud) != ESP_OK) {
+        return PN532_ERR_I2C;
+    }
+    dev->bus_baud = baud;
+    hsu_discard_input(dev);
+    return PN532_OK;
+}
+
+const pn532_transport_ops_t pn532_hsu_transport = {
+    .name          = "HSU",
+    .init          = hsu_init,
+    .writev        = hsu_writev,
+    .read          = hsu_read,
+    .is_ready      = hsu_is_ready,
+    .read_continue = hsu_read_continue,
+    .buffered      = hsu_buffered,
+    .wait_ready    = hsu_wait_ready,
+    .set_baud      = hsu_set_baud,
+};
@@ -0,0 +1,213 @@
+/**
+ * PN532 I2C transport (doc §1.2, §7).
+ * Command links are built in static storage so steady-state polling never
+ * touches the heap; every transaction is timed with esp_timer. Several readers
+ * may share one port (different addresses); a per-port mutex serializes them.
+ */
+
+#include "pn532_transport.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "pn532_i2c";
+
+#define I2C_WRITE_TICKS   pdMS_TO_TICKS(PN532_I2C_WRITE_TIMEOUT_MS)
+#define I2C_READ_TICKS    pdMS_TO_TICKS(PN532_I2C_READ_TIMEOUT_MS)
+
+/* Largest link: start, address, one write per frame piece, stop */
+#define I2C_LINK_OPS      (3 + PN532_IOV_MAX)
+
+/* Bus recovery: clocks to free a slave stuck mid-byte, half period at ~100 kHz */
+#define I2C_RECOVER_CLOCKS  9
+#define I2C_RECOVER_HALF_US 5
+
+/* Per-port state; one link buffer per port is enough since the mutex serializes use (doc §16.3) */
+typedef struct {
+    bool installed;
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t lock_buf;
+    uint8_t link_buf[I2C_LINK_RECOMMENDED_SIZE(I2C_LINK_OPS)];
+} i2c_port_state_t;
+
+static i2c_port_state_t s_ports[I2C_NUM_MAX];
+
+/* Route the pins to the controller and install the master driver */
+static pn532_err_t i2c_install(const pn532_i2c_config_t *cfg)
+{
+    i2c_config_t conf = {
+        .mode             = I2C_MODE_MASTER,
+        .sda_io_num       = cfg->sda_gpio,
+        .scl_io_num       = cfg->scl_gpio,
+        .sda_pullup_en    = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en    = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = cfg->freq_hz,
+        .clk_flags        = 0,
+    };
+
+    esp_err_t ret = i2c_param_config(cfg->port, &conf);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_param_config failed %d", ret);
+        return PN532_ERR_I2C;
+    }
+
+    ret = i2c_driver_install(cfg->port, I2C_MODE_MASTER, 0, 0, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "i2c_driver_install failed %d", ret);
+        return PN532_ERR_I2C;
+    }
+    return PN532_OK;
+}
+
+/* Called from pn532_init() only, i.e. before any reader on this port runs transactions */
+static pn532_err_t i2c_init(pn532_dev_t *dev)
+{
+    const pn532_i2c_config_t *cfg = &dev->config.i2c;
+    if (cfg->port < 0 || cfg->port >= I2C_NUM_MAX) {
+        ESP_LOGE(TAG, "invalid I2C port %d", cfg->port);
+        return PN532_ERR_I2C;
+    }
+    i2c_port_state_t *ps = &s_ports[cfg->port];
+    if (ps->installed) {
+        return PN532_OK;
+    }
+    pn532_err_t err = i2c_install(cfg);
+    if (err != PN532_OK) {
+        return err;
+    }
+    ps->lock = xSemaphoreCreateMutexStatic(&ps->lock_buf);
+    ps->installed = true;
+    return PN532_OK;
+}
+
+/* Each piece becomes one write op pointing at the caller's bytes; nothing is copied */
+static pn532_err_t i2c_writev(pn532_dev_t *dev, const pn532_iovec_t *iov, unsigned iovcnt)
+{
+    i2c_port_state_t *ps = &s_ports[dev->config.i2c.port];
+    xSemaphoreTake(ps->lock, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(ps->link_buf, sizeof(ps->link_buf));
+    if (!cmd) {
+        xSemaphoreGive(ps->lock);
+        pn532_transport_record(dev, start, false);
+        return PN532_ERR_I2C;
+    }
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (dev->config.i2c.addr_7bit << 1) | I2C_MASTER_WRITE, true);
+    for (unsigned k = 0; k < iovcnt; k++) {
+        if (iov[k].len > 0) {
+            i2c_master_write(cmd, iov[k].data, iov[k].len, true);
+        }
+    }
+    i2c_master_stop(cmd);
+    esp_err_t ret = i2c_master_cmd_begin(dev->config.i2c.port, cmd, I2C_WRITE_TICKS);
+    i2c_cmd_link_delete_static(cmd);
+    xSemaphoreGive(ps->lock);
+    pn532_transport_record(dev, start, ret == ESP_OK);
+    return (ret == ESP_OK) ? PN532_OK : PN532_ERR_I2C;
+}
+
+static pn532_err_t i2c_read(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    if (len == 0) {
+        return PN532_OK;
+    }
+    i2c_port_state_t *ps = &s_ports[dev->config.i2c.port];
+    xSemaphoreTake(ps->lock, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(ps->link_buf, sizeof(ps->link_buf));
+    if (!cmd) {
+        xSemaphoreGive(ps->lock);
+        pn532_transport_record(dev, start, false);
+        return PN532_ERR_I2C;
+    }
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (dev->config.i2c.addr_7bit << 1) | I2C_MASTER_READ, true);
+    if (len > 1) {
+        i2c_master_read(cmd, buf, len - 1, I2C_MASTER_ACK);
+    }
+    i2c_master_read_byte(cmd, buf + len - 1, I2C_MASTER_NACK);
+    i2c_master_stop(cmd);
+    esp_err_t ret = i2c_master_cmd_begin(dev->config.i2c.port, cmd, I2C_READ_TICKS);
+    i2c_cmd_link_delete_static(cmd);
+    xSemaphoreGive(ps->lock);
+    pn532_transport_record(dev, start, ret == ESP_OK);
+    return (ret == ESP_OK) ? PN532_OK : PN532_ERR_I2C;
+}
+
+/* Check ready: read 1 byte, true if 0x01 (doc §7.3) */
+static bool i2c_is_ready(pn532_dev_t *dev)
+{
+    uint8_t b;
+    if (i2c_read(dev, &b, 1) != PN532_OK) {
+        return false;
+    }
+    return (b == PN532_I2C_READY);
+}
+
+/* Bit-banged SCL/SDA edge, then half a clock period */
+static void i2c_recover_edge(int gpio, uint32_t level)
+{
+    gpio_set_level(gpio, level);
+    esp_rom_delay_us(I2C_RECOVER_HALF_US);
+}
+
+/*
+ * Bus recovery (doc §15.4). A slave reset or interrupted mid-byte may hold
+ * SDA low until it has clocked out the rest of that byte, so SCL is pulsed
+ * 9 times with SDA released, then a STOP is generated by hand. Deleting and
+ * re-installing the driver resets the controller's state machine and FIFOs.
+ * Other readers on the port wait on the port mutex meanwhile; devices driven
+ * by other modules on the same pins must not be accessed during recovery.
+ */
+static pn532_err_t i2c_recover(pn532_dev_t *dev)
+{
+    const pn532_i2c_config_t *cfg = &dev->config.i2c;
+    i2c_port_state_t *ps = &s_ports[cfg->port];
+    xSemaphoreTake(ps->lock, portMAX_DELAY);
+    (void)i2c_driver_delete(cfg->port);
+
+    gpio_config_t io = {
+        .pin_bit_mask = (1ULL << cfg->sda_gpio) | (1ULL << cfg->scl_gpio),
+        .mode         = GPIO_MODE_INPUT_OUTPUT_OD,
+        .pull_up_en   = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type    = GPIO_INTR_DISABLE,
+    };
+    gpio_set_level(cfg->sda_gpio, 1);
+    gpio_set_level(cfg->scl_gpio, 1);
+    bool released = false;
+    if (gpio_config(&io) == ESP_OK) {
+        for (int i = 0; i < I2C_RECOVER_CLOCKS; i++) {
+            i2c_recover_edge(cfg->scl_gpio, 0);
+            i2c_recover_edge(cfg->scl_gpio, 1);
+        }
+        /* STOP: SDA rises while SCL is high */
+        i2c_recover_edge(cfg->scl_gpio, 0);
+        i2c_recover_edge(cfg->sda_gpio, 0);
+        i2c_recover_edge(cfg->scl_gpio, 1);
+        i2c_recover_edge(cfg->sda_gpio, 1);
+        released = gpio_get_level(cfg->sda_gpio) == 1;
+    }
+
+    pn532_err_t err = i2c_install(cfg);
+    xSemaphoreGive(ps->lock);
+    if (!released) {
+        ESP_LOGW(TAG, "SDA still held low after recovery clocks");
+        return PN532_ERR_I2C;
+    }
+    return err;
+}
+
+const pn532_transport_ops_t pn532_i2c_transport = {
+    .name     = "I2C",
+    .init     = i2c_init,
+    .writev   = i2c_writev,
+    .read     = i2c_read,
+    .is_ready = i2c_is_ready,
+    .recover  = i2c_recover,
+};
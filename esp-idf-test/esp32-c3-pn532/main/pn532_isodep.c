@@ -0,0 +1,208 @@
+/**
+ * ISO14443-4 (ISO-DEP) APDU exchange and NFC Forum Type 4 NDEF read over
+ * InDataExchange. See TECHNICAL_DOCUMENTATION.md §10.6.
+ */
+
+#include "pn532.h"
+#include <string.h>
+
+/* ISO 7816-4 instructions used by the Type 4 read sequence */
+#define APDU_INS_SELECT        0xA4
+#define APDU_INS_READ_BINARY   0xB0
+#define APDU_SW_OK             0x9000
+#define APDU_MAX_OFFSET        0x7FFF  /* READ BINARY P1 bit 7 must stay clear */
+
+/* Type 4 Tag capability container (doc §10.6) */
+#define T4_CC_FILE_ID          0xE103
+#define T4_CC_LEN              15
+#define T4_NDEF_FILE_CTRL_TLV  0x04
+#define T4_NLEN_LEN            2
+
+static const uint8_t NDEF_APP_AID[] = { 0xD2, 0x76, 0x00, 0x00, 0x85, 0x01, 0x01 };
+
+static uint16_t get_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+pn532_err_t pn532_apdu_exchange(pn532_dev_t *dev, uint8_t tg, const uint8_t *capdu, size_t capdu_len,
+                                uint8_t *rapdu, size_t rapdu_max, size_t *rapdu_len)
+{
+    if (!capdu || capdu_len == 0 || !rapdu || !rapdu_len) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* Command chaining: every piece but the last carries MI in Tg */
+    uint8_t status = 0;
+    size_t got = 0;
+    size_t sent = 0;
+    while (sent < capdu_len) {
+        size_t n = capdu_len - sent;
+        uint8_t t = tg;
+        if (n > PN532_DATA_EXCHANGE_MAX_LEN) {
+            n = PN532_DATA_EXCHANGE_MAX_LEN;
+            t |= PN532_TG_MI;
+        }
+        pn532_err_t err = pn532_data_exchange_status(dev, t, capdu + sent, n,
+                                                     rapdu, rapdu_max, &got, &status);
+        if (err != PN532_OK) {
+            return err;
+        }
+        sent += n;
+    }
+
+    /* Response chaining: each piece goes straight behind the previous one */
+    size_t have = got;
+    while (status & PN532_STATUS_MI) {
+        pn532_err_t err = pn532_data_exchange_status(dev, tg, NULL, 0, rapdu + have,
+                                                     rapdu_max - have, &got, &status);
+        if (err != PN532_OK) {
+            return err;
+        }
+        have += got;
+    }
+
+    if (have < PN532_APDU_SW_LEN) {
+        return PN532_ERR_RESPONSE;
+    }
+    *rapdu_len = have;
+    return PN532_OK;
+}
+
+/* Exchange an APDU that must end in SW 90 00; *data_len excludes the SW */
+static pn532_err_t apdu_expect_ok(pn532_dev_t *dev, uint8_t tg, const uint8_t *capdu, size_t capdu_len,
+                                  uint8_t *rapdu, size_t rapdu_max, size_t *data_len)
+{
+    size_t len = 0;
+    pn532_err_t err = pn532_apdu_exchange(dev, tg, capdu, capdu_len, rapdu, rapdu_max, &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (get_be16(rapdu + len - PN532_APDU_SW_LEN) != APDU_SW_OK) {
+        return PN532_ERR_TARGET;
+    }
+    *data_len = len - PN532_APDU_SW_LEN;
+    return PN532_OK;
+}
+
+/* SELECT by file identifier, no response data (P2 = 0x0C) */
+static pn532_err_t select_file(pn532_dev_t *dev, uint8_t tg, uint16_t fid)
+{
+    const uint8_t capdu[] = { 0x00, APDU_INS_SELECT, 0x00, 0x0C, 0x02,
+                              (uint8_t)(fid >> 8), (uint8_t)fid };
+    uint8_t rapdu[PN532_APDU_SW_LEN];
+    size_t len;
+    return apdu_expect_ok(dev, tg, capdu, sizeof(capdu), rapdu, sizeof(rapdu), &len);
+}
+
+/* READ BINARY of le bytes (1..256) at offset; rapdu needs le + 2 bytes */
+static pn532_err_t read_binary(pn532_dev_t *dev, uint8_t tg, uint16_t offset, size_t le,
+                               uint8_t *rapdu, size_t rapdu_max, size_t *data_len)
+{
+    const uint8_t capdu[] = { 0x00, APDU_INS_READ_BINARY, (uint8_t)(offset >> 8), (uint8_t)offset,
+                              (uint8_t)(le == PN532_APDU_MAX_SHORT_LE ? 0x00 : le) };
+    return apdu_expect_ok(dev, tg, capdu, sizeof(capdu), rapdu, rapdu_max, data_len);
+}
+
+pn532_err_t pn532_type4_read_ndef(pn532_dev_t *dev, uint8_t tg, uint8_t *out, size_t out_max,
+                                  size_t *out_len)
+{
+    if (!out || !out_len) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* SELECT NDEF Tag Application by name; any FCI in the reply is ignored */
+    uint8_t capdu[6 + sizeof(NDEF_APP_AID)] = { 0x00, APDU_INS_SELECT, 0x04, 0x00,
+                                                sizeof(NDEF_APP_AID) };
+    memcpy(capdu + 5, NDEF_APP_AID, sizeof(NDEF_APP_AID));
+    capdu[sizeof(capdu) - 1] = 0x00; /* Le */
+    uint8_t rapdu[T4_CC_LEN + PN532_APDU_SW_LEN];
+    size_t len = 0;
+    pn532_err_t err = pn532_apdu_exchange(dev, tg, capdu, sizeof(capdu), out, out_max, &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (get_be16(out + len - PN532_APDU_SW_LEN) != APDU_SW_OK) {
+        return PN532_ERR_TARGET;
+    }
+
+    /* Capability container: CCLEN, version, MLe, MLc, NDEF File Control TLV */
+    err = select_file(dev, tg, T4_CC_FILE_ID);
+    if (err == PN532_OK) {
+        err = read_binary(dev, tg, 0, T4_CC_LEN, rapdu, sizeof(rapdu), &len);
+    }
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < T4_CC_LEN || rapdu[7] != T4_NDEF_FILE_CTRL_TLV || rapdu[8] < 6) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+    uint8_t major = rapdu[2] >> 4;
+    if (major < 2 || major > 3 || rapdu[13] != 0x00) {
+        /* Unknown mapping version, or read access not granted */
+        return PN532_ERR_UNSUPPORTED;
+    }
+    size_t mle = get_be16(rapdu + 3);
+    uint16_t ndef_fid = get_be16(rapdu + 9);
+
+    err = select_file(dev, tg, ndef_fid);
+    if (err == PN532_OK) {
+        err = read_binary(dev, tg, 0, T4_NLEN_LEN, rapdu, sizeof(rapdu), &len);
+    }
+    if (err != PN532_OK) {
+        return err;
+    }
+    if (len < T4_NLEN_LEN) {
+        return PN532_ERR_RESPONSE;
+    }
+    size_t nlen = get_be16(rapdu);
+    if (nlen > out_max) {
+        return PN532_ERR_SIZE;
+    }
+    if (nlen + T4_NLEN_LEN - 1 > APDU_MAX_OFFSET) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+
+    /* Largest short Le the tag accepts; MLe < 0x0F is invalid, treat as 15 */
+    size_t le_max = (mle > PN532_APDU_MAX_SHORT_LE) ? PN532_APDU_MAX_SHORT_LE : mle;
+    if (le_max < T4_CC_LEN) {
+        le_max = T4_CC_LEN;
+    }
+
+    /*
+     * Each chunk is read in place at out + have; its SW lands just past the
+     * data and is overwritten by the next chunk. Near the end of the caller's
+     * buffer the chunk is shortened to leave room for the SW, and only the
+     * last one or two bytes bounce through tail.
+     */
+    size_t have = 0;
+    while (have < nlen) {
+        size_t n = nlen - have;
+        if (n > le_max) {
+            n = le_max;
+        }
+        size_t room = out_max - have;
+        if (room < n + PN532_APDU_SW_LEN && room > PN532_APDU_SW_LEN) {
+            n = room - PN532_APDU_SW_LEN;
+        }
+        uint16_t offset = (uint16_t)(T4_NLEN_LEN + have);
+        if (room >= n + PN532_APDU_SW_LEN) {
+            err = read_binary(dev, tg, offset, n, out + have, room, &len);
+        } else {
+            uint8_t tail[2 * PN532_APDU_SW_LEN];
+            err = read_binary(dev, tg, offset, n, tail, sizeof(tail), &len);
+            if (err == PN532_OK && len <= n) {
+                memcpy(out + have, tail, len);
+            }
+        }
+        if (err != PN532_OK) {
+            return err;
+        }
+        if (len == 0 || len > n) {
+            return PN532_ERR_RESPONSE;
+        }
+        have += len;
+    }
+    *out_len = nlen;
+    return PN532_OK;
+}
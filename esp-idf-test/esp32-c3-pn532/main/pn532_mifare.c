@@ -0,0 +1,203 @@
+/**
+ * MIFARE Classic authentication and sector reads over InDataExchange, with a
+ * per-reader, per-UID cache of the key that worked for each sector.
+ * See TECHNICAL_DOCUMENTATION.md §10.8.
+ */
+
+#include "pn532.h"
+#include <string.h>
+
+#define MIFARE_1K_SECTORS     16
+#define MIFARE_4K_SECTORS     PN532_MIFARE_MAX_SECTORS
+#define MIFARE_SMALL_SECTORS  32    /* sectors 0-31 have 4 blocks, 32-39 have 16 */
+#define MIFARE_AUTH_UID_LEN   4
+
+#define MIFARE_NO_KEY         0xFF  /* sector_key[] entry for a sector with no known key */
+
+/* Index of key in keys[0..count-1], count if absent */
+static unsigned key_index(const pn532_mifare_key_t *keys, unsigned count, const pn532_mifare_key_t *key)
+{
+    unsigned i = 0;
+    while (i < count && memcmp(&keys[i], key, sizeof(*key)) != 0) {
+        i++;
+    }
+    return i;
+}
+
+static pn532_mifare_key_entry_t *key_cache_find(pn532_dev_t *dev, const pn532_tag_info_t *tag)
+{
+    for (unsigned i = 0; i < PN532_MIFARE_KEY_CACHE_LEN; i++) {
+        pn532_mifare_key_entry_t *e = &dev->mifare_keys.cards[i];
+        if (e->used && e->uid_len == tag->uid_length && memcmp(e->uid, tag->uid, e->uid_len) == 0) {
+            e->last_use = ++dev->mifare_keys.clock;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void key_cache_store(pn532_dev_t *dev, const pn532_tag_info_t *tag, uint8_t sector,
+                            const pn532_mifare_key_t *key)
+{
+    pn532_mifare_key_entry_t *cards = dev->mifare_keys.cards;
+    pn532_mifare_key_entry_t *e = key_cache_find(dev, tag);
+    if (!e) {
+        /* Free slot, else the least recently used one */
+        e = &cards[0];
+        for (unsigned i = 0; i < PN532_MIFARE_KEY_CACHE_LEN && e->used; i++) {
+            if (!cards[i].used || cards[i].last_use < e->last_use) {
+                e = &cards[i];
+            }
+        }
+        memset(e, 0, sizeof(*e));
+        memset(e->sector_key, MIFARE_NO_KEY, sizeof(e->sector_key));
+        e->used = true;
+        memcpy(e->uid, tag->uid, tag->uid_length);
+        e->uid_len = tag->uid_length;
+        e->last_use = ++dev->mifare_keys.clock;
+    }
+
+    uint8_t k = (uint8_t)key_index(e->keys, e->key_count, key);
+    if (k == e->key_count) {
+        if (e->key_count < PN532_MIFARE_KEYS_PER_UID) {
+            e->key_count++;
+        } else {
+            /* Recycle the oldest slot; sectors it opened are looked up again */
+            k = e->next_key;
+            e->next_key = (uint8_t)((k + 1) % PN532_MIFARE_KEYS_PER_UID);
+            for (unsigned s = 0; s < MIFARE_4K_SECTORS; s++) {
+                if (e->sector_key[s] == k) {
+                    e->sector_key[s] = MIFARE_NO_KEY;
+                }
+            }
+        }
+        e->keys[k] = *key;
+    }
+    e->sector_key[sector] = k;
+}
+
+void pn532_mifare_key_cache_clear(pn532_dev_t *dev)
+{
+    memset(&dev->mifare_keys, 0, sizeof(dev->mifare_keys));
+}
+
+pn532_err_t pn532_mifare_auth(pn532_dev_t *dev, const pn532_tag_info_t *tag, uint8_t block,
+                              const pn532_mifare_key_t *key)
+{
+    if (!tag || !key || tag->uid_length < MIFARE_AUTH_UID_LEN ||
+        (key->auth_cmd != PN532_MIFARE_CMD_AUTH_A && key->auth_cmd != PN532_MIFARE_CMD_AUTH_B)) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /* Cmd, block, key, UID: cascade level 1 for 4-byte UIDs, level 2 (last 4 bytes) for 7-byte */
+    uint8_t cmd[2 + PN532_MIFARE_KEY_LEN + MIFARE_AUTH_UID_LEN] = { key->auth_cmd, block };
+    memcpy(cmd + 2, key->key, PN532_MIFARE_KEY_LEN);
+    memcpy(cmd + 2 + PN532_MIFARE_KEY_LEN, tag->uid + tag->uid_length - MIFARE_AUTH_UID_LEN,
+           MIFARE_AUTH_UID_LEN);
+    size_t len = 0;
+    return pn532_data_exchange(dev, tag->tg, cmd, sizeof(cmd), NULL, 0, &len);
+}
+
+pn532_err_t pn532_mifare_read_block(pn532_dev_t *dev, uint8_t tg, uint8_t block,
+                                    uint8_t out[PN532_MIFARE_BLOCK_SIZE])
+{
+    if (!out) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    const uint8_t cmd[] = { PN532_MIFARE_CMD_READ, block };
+    size_t len = 0;
+    pn532_err_t err = pn532_data_exchange(dev, tg, cmd, sizeof(cmd), out, PN532_MIFARE_BLOCK_SIZE, &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    return (len == PN532_MIFARE_BLOCK_SIZE) ? PN532_OK : PN532_ERR_RESPONSE;
+}
+
+/*
+ * Authenticate with the key cached for this sector first, then the other
+ * keys that worked on this card (sectors of one card tend to share keys),
+ * then the candidates. A wrong key leaves the card IDLE, so every retry
+ * after a failure re-activates it; that round trip is what makes a cold
+ * key search slow.
+ */
+static pn532_err_t mifare_auth_sector(pn532_dev_t *dev, pn532_tag_info_t *tag, uint8_t sector,
+                                      uint8_t block, const pn532_mifare_key_t *keys, unsigned key_count)
+{
+    pn532_mifare_key_t known[PN532_MIFARE_KEYS_PER_UID];
+    unsigned known_count = 0;
+    const pn532_mifare_key_entry_t *cached = key_cache_find(dev, tag);
+    if (cached) {
+        uint8_t own = cached->sector_key[sector];
+        if (own != MIFARE_NO_KEY) {
+            known[known_count++] = cached->keys[own];
+        }
+        for (uint8_t k = 0; k < cached->key_count; k++) {
+            if (k != own) {
+                known[known_count++] = cached->keys[k];
+            }
+        }
+    }
+    bool failed = false;
+
+    for (unsigned i = 0; i < known_count + key_count; i++) {
+        const pn532_mifare_key_t *key = (i < known_count) ? &known[i] : &keys[i - known_count];
+        if (i >= known_count && key_index(known, known_count, key) < known_count) {
+            continue;   /* Already tried from the cache */
+        }
+        if (failed) {
+            pn532_err_t err = pn532_reselect_target(dev, tag);
+            if (err != PN532_OK) {
+                return err;
+            }
+        }
+        pn532_err_t err = pn532_mifare_auth(dev, tag, block, key);
+        if (err == PN532_OK) {
+            key_cache_store(dev, tag, sector, key);
+            return PN532_OK;
+        }
+        if (err != PN532_ERR_TARGET) {
+            return err;
+        }
+        failed = true;
+    }
+    return PN532_ERR_TARGET;
+}
+
+pn532_err_t pn532_mifare_read_sector(pn532_dev_t *dev, pn532_tag_info_t *tag, uint8_t sector,
+                                     const pn532_mifare_key_t *keys, unsigned key_count,
+                                     uint8_t *out, size_t out_max, size_t *out_len)
+{
+    if (!tag || (!keys && key_count > 0) || !out || !out_len) {
+        return PN532_ERR_RESPONSE;
+    }
+    unsigned sectors = (tag->type == PN532_TAG_MIFARE_CLASSIC_1K) ? MIFARE_1K_SECTORS
+                     : (tag->type == PN532_TAG_MIFARE_CLASSIC_4K) ? MIFARE_4K_SECTORS : 0;
+    if (sector >= sectors) {
+        return PN532_ERR_UNSUPPORTED;
+    }
+
+    unsigned first_block;
+    unsigned blocks;
+    if (sector < MIFARE_SMALL_SECTORS) {
+        first_block = sector * 4u;
+        blocks = 4;
+    } else {
+        first_block = MIFARE_SMALL_SECTORS * 4u + (sector - MIFARE_SMALL_SECTORS) * 16u;
+        blocks = PN532_MIFARE_MAX_SECTOR_BLOCKS;
+    }
+    if (blocks * PN532_MIFARE_BLOCK_SIZE > out_max) {
+        return PN532_ERR_SIZE;
+    }
+
+    pn532_err_t err = mifare_auth_sector(dev, tag, sector, (uint8_t)first_block, keys, key_count);
+    for (unsigned b = 0; b < blocks && err == PN532_OK; b++) {
+        err = pn532_mifare_read_block(dev, tag->tg, (uint8_t)(first_block + b),
+                                      out + b * PN532_MIFARE_BLOCK_SIZE);
+    }
+    if (err != PN532_OK) {
+        return err;
+    }
+    *out_len = blocks * PN532_MIFARE_BLOCK_SIZE;
+    return PN532_OK;
+}
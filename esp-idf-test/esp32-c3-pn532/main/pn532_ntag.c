@@ -0,0 +1,133 @@
+/**
+ * NTAG / MIFARE Ultralight memory access over InDataExchange.
+ * See TECHNICAL_DOCUMENTATION.md §10.3.
+ */
+
+#include "pn532.h"
+#include "esp_timer.h"
+#include <string.h>
+
+pn532_err_t pn532_ntag_read(pn532_dev_t *dev, uint8_t tg, uint8_t page, uint8_t out[PN532_NTAG_READ_LEN])
+{
+    if (!out) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    const uint8_t cmd[] = { PN532_NTAG_CMD_READ, page };
+    size_t len = 0;
+    pn532_err_t err = pn532_data_exchange(dev, tg, cmd, sizeof(cmd), out, PN532_NTAG_READ_LEN, &len);
+    if (err != PN532_OK) {
+        return err;
+    }
+    /* A 4-bit NAK comes back as a short reply */
+    return (len == PN532_NTAG_READ_LEN) ? PN532_OK : PN532_ERR_RESPONSE;
+}
+
+pn532_err_t pn532_ntag_fast_read(pn532_dev_t *dev, uint8_t tg, uint8_t start_page, uint8_t end_page,
+                                 uint8_t *out, size_t out_max)
+{
+    if (!out || end_page < start_page) {
+        return PN532_ERR_RESPONSE;
+    }
+    size_t total = ((size_t)end_page - start_page + 1) * PN532_NTAG_PAGE_SIZE;
+    if (total > out_max) {
+        return PN532_ERR_SIZE;
+    }
+
+    unsigned page = start_page;
+    while (page <= end_page) {
+        unsigned last = page + PN532_NTAG_FAST_READ_MAX_PAGES - 1;
+        if (last > end_page) {
+            last = end_page;
+        }
+        size_t want = (last - page + 1) * PN532_NTAG_PAGE_SIZE;
+
+        const uint8_t cmd[] = { PN532_NTAG_CMD_FAST_READ, (uint8_t)page, (uint8_t)last };
+        size_t len = 0;
+        pn532_err_t err = pn532_data_exchange(dev, tg, cmd, sizeof(cmd), out, want, &len);
+        if (err != PN532_OK) {
+            return err;
+        }
+        if (len != want) {
+            return PN532_ERR_RESPONSE;
+        }
+        out += want;
+        page = last + 1;
+    }
+    return PN532_OK;
+}
+
+/* Read pages back one FAST_READ chunk at a time and compare against data */
+static pn532_err_t ntag_verify(pn532_dev_t *dev, uint8_t tg, uint8_t start_page, const uint8_t *data,
+                               unsigned page_count)
+{
+    uint8_t chunk[PN532_NTAG_FAST_READ_MAX_PAGES * PN532_NTAG_PAGE_SIZE];
+    unsigned done = 0;
+    while (done < page_count) {
+        unsigned n = page_count - done;
+        if (n > PN532_NTAG_FAST_READ_MAX_PAGES) {
+            n = PN532_NTAG_FAST_READ_MAX_PAGES;
+        }
+        uint8_t first = (uint8_t)(start_page + done);
+        uint8_t last = (uint8_t)(first + n - 1);
+        pn532_err_t err = pn532_ntag_fast_read(dev, tg, first, last, chunk, sizeof(chunk));
+        if (err != PN532_OK) {
+            return err;
+        }
+        if (memcmp(chunk, data + done * PN532_NTAG_PAGE_SIZE, n * PN532_NTAG_PAGE_SIZE) != 0) {
+            return PN532_ERR_TARGET;
+        }
+        done += n;
+    }
+    return PN532_OK;
+}
+
+pn532_err_t pn532_ntag_write_pages(pn532_dev_t *dev, uint8_t tg, uint8_t start_page, const uint8_t *data,
+                                   unsigned page_count, bool verify, pn532_ntag_write_result_t *result)
+{
+    pn532_ntag_write_result_t res = { 0 };
+    if (result) {
+        *result = res;
+    }
+    if (!data || page_count == 0 || start_page + page_count - 1 > 0xFF) {
+        return PN532_ERR_RESPONSE;
+    }
+
+    /*
+     * The target stays selected from the detection that found it: no
+     * re-select per page, just WRITE, page, 4 data bytes. The tag's 4-bit ACK
+     * is reported as Status 0x00 with no data; a NAK shows up as a status
+     * error or a one-byte reply.
+     */
+    pn532_err_t err = PN532_OK;
+    int64_t t0 = esp_timer_get_time();
+    for (unsigned i = 0; i < page_count && err == PN532_OK; i++) {
+        uint8_t cmd[2 + PN532_NTAG_PAGE_SIZE] = { PN532_NTAG_CMD_WRITE, (uint8_t)(start_page + i) };
+        memcpy(cmd + 2, data + i * PN532_NTAG_PAGE_SIZE, PN532_NTAG_PAGE_SIZE);
+        uint8_t nak;
+        size_t len = 0;
+        err = pn532_data_exchange(dev, tg, cmd, sizeof(cmd), &nak, sizeof(nak), &len);
+        if (err == PN532_OK && len != 0) {
+            err = PN532_ERR_TARGET;
+        }
+        if (err == PN532_OK) {
+            res.pages++;
+        }
+    }
+    int64_t t1 = esp_timer_get_time();
+    res.write_us = (uint32_t)(t1 - t0);
+
+    if (err == PN532_OK && verify) {
+        err = ntag_verify(dev, tg, start_page, data, page_count);
+        res.verify_us = (uint32_t)(esp_timer_get_time() - t1);
+    }
+
+    uint64_t total_us = (uint64_t)res.write_us + res.verify_us;
+    if (total_us > 0) {
+        res.pages_per_s = (uint32_t)((uint64_t)res.pages * 1000000 / total_us);
+    }
+    if (result) {
+        *result = res;
+    }
+    return err;
+}
@@ -0,0 +1,186 @@
+/**
+ * PN532 SPI transport (doc §1.4, §7.5).
+ * Mode 0, LSB first. Every transaction starts with a prefix byte: 0x01 data
+ * write, 0x02 status read, 0x03 data read. Frame transfers are queued to the
+ * DMA engine out of per-host bounce buffers; at 5 MHz a full 264-byte frame
+ * takes ~0.4 ms on the wire versus ~24 ms on 100 kHz I2C.
+ */
+
+#include "pn532_transport.h"
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "pn532_spi";
+
+#define SPI_QUEUE_TICKS   pdMS_TO_TICKS(PN532_SPI_TIMEOUT_MS)
+
+/* Prefix byte + largest frame, rounded up to whole words for DMA */
+#define SPI_XFER_MAX      ((1 + PN532_FRAME_MAX_LEN + 3) & ~3)
+
+/* Per-host state; the mutex guards the bounce buffers between readers on one host */
+typedef struct {
+    bool installed;
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t lock_buf;
+    WORD_ALIGNED_ATTR uint8_t tx[SPI_XFER_MAX];
+    WORD_ALIGNED_ATTR uint8_t rx[SPI_XFER_MAX];
+} spi_host_state_t;
+
+static DMA_ATTR spi_host_state_t s_hosts[SOC_SPI_PERIPH_NUM];
+
+static spi_host_state_t *host_of(pn532_dev_t *dev)
+{
+    return &s_hosts[dev->config.spi.host];
+}
+
+/*
+ * One full-duplex DMA transaction of n bytes from hs->tx (into hs->rx if rx).
+ * Once queued the transfer always completes, so the result wait is unbounded:
+ * returning early would leave the driver holding a dead stack descriptor.
+ */
+static esp_err_t spi_xfer(pn532_dev_t *dev, spi_host_state_t *hs, size_t n, bool rx)
+{
+    spi_transaction_t t = {
+        .length    = n * 8,
+        .tx_buffer = hs->tx,
+        .rx_buffer = rx ? hs->rx : NULL,
+    };
+    esp_err_t ret = spi_device_queue_trans(dev->bus_handle, &t, SPI_QUEUE_TICKS);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    spi_transaction_t *done;
+    return spi_device_get_trans_result(dev->bus_handle, &done, portMAX_DELAY);
+}
+
+/* Called from pn532_init() only, i.e. before any reader on this host runs transactions */
+static pn532_err_t spi_init(pn532_dev_t *dev)
+{
+    const pn532_spi_config_t *cfg = &dev->config.spi;
+    if (dev->bus_handle) {
+        return PN532_OK;
+    }
+    if (cfg->host < 0 || cfg->host >= SOC_SPI_PERIPH_NUM) {
+        ESP_LOGE(TAG, "invalid SPI host %d", cfg->host);
+        return PN532_ERR_I2C;
+    }
+
+    spi_host_state_t *hs = host_of(dev);
+    if (!hs->installed) {
+        spi_bus_config_t bus = {
+            .mosi_io_num     = cfg->mosi_gpio,
+            .miso_io_num     = cfg->miso_gpio,
+            .sclk_io_num     = cfg->sclk_gpio,
+            .quadwp_io_num   = -1,
+            .quadhd_io_num   = -1,
+            .max_transfer_sz = SPI_XFER_MAX,
+        };
+        /* Bus may already be set up by another module sharing it */
+        esp_err_t ret = spi_bus_initialize(cfg->host, &bus, SPI_DMA_CH_AUTO);
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "spi_bus_initialize failed %d", ret);
+            return PN532_ERR_I2C;
+        }
+        hs->lock = xSemaphoreCreateMutexStatic(&hs->lock_buf);
+        hs->installed = true;
+    }
+
+    spi_device_interface_config_t devcfg = {
+        .mode           = 0,
+        .clock_speed_hz = (int)cfg->clock_hz,
+        .spics_io_num   = cfg->cs_gpio,
+        .flags          = SPI_DEVICE_BIT_LSBFIRST,
+        .queue_size     = 1,
+    };
+    spi_device_handle_t handle;
+    esp_err_t ret = spi_bus_add_device(cfg->host, &devcfg, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "spi_bus_add_device failed %d", ret);
+        return PN532_ERR_I2C;
+    }
+    dev->bus_handle = handle;
+    return PN532_OK;
+}
+
+/*
+ * DW prefix + frame (doc §7.5). The pieces are gathered into the DMA bounce
+ * buffer: the prefix must lead and caller memory need not be DMA-capable.
+ */
+static pn532_err_t spi_writev(pn532_dev_t *dev, const pn532_iovec_t *iov, unsigned iovcnt)
+{
+    spi_host_state_t *hs = host_of(dev);
+    size_t len = 0;
+    for (unsigned k = 0; k < iovcnt; k++) {
+        len += iov[k].len;
+    }
+    if (len + 1 > sizeof(hs->tx)) {
+        return PN532_ERR_SIZE;
+    }
+    xSemaphoreTake(hs->lock, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    hs->tx[0] = PN532_SPI_DATA_WRITE;
+    size_t off = 1;
+    for (unsigned k = 0; k < iovcnt; k++) {
+        memcpy(hs->tx + off, iov[k].data, iov[k].len);
+        off += iov[k].len;
+    }
+    esp_err_t ret = spi_xfer(dev, hs, len + 1, false);
+    xSemaphoreGive(hs->lock);
+    pn532_transport_record(dev, start, ret == ESP_OK);
+    return (ret == ESP_OK) ? PN532_OK : PN532_ERR_I2C;
+}
+
+/*
+ * DR prefix, then len - 1 frame bytes. SPI has no ready byte in the data
+ * stream, so buf[0] is filled with PN532_I2C_READY to keep the I2C layout
+ * the frame parser expects; callers only read after a ready check anyway.
+ */
+static pn532_err_t spi_read(pn532_dev_t *dev, uint8_t *buf, size_t len)
+{
+    if (len == 0) {
+        return PN532_OK;
+    }
+    spi_host_state_t *hs = host_of(dev);
+    if (len > sizeof(hs->rx)) {
+        return PN532_ERR_SIZE;
+    }
+    xSemaphoreTake(hs->lock, portMAX_DELAY);
+    int64_t start = esp_timer_get_time();
+    hs->tx[0] = PN532_SPI_DATA_READ;
+    memset(hs->tx + 1, 0, len - 1);
+    esp_err_t ret = spi_xfer(dev, hs, len, true);
+    if (ret == ESP_OK) {
+        buf[0] = PN532_I2C_READY;
+        memcpy(buf + 1, hs->rx + 1, len - 1);
+    }
+    xSemaphoreGive(hs->lock);
+    pn532_transport_record(dev, start, ret == ESP_OK);
+    return (ret == ESP_OK) ? PN532_OK : PN532_ERR_I2C;
+}
+
+/* SR prefix; bit 0 of the status byte is RDY (doc §7.5). Two bytes: polled, no DMA */
+static bool spi_is_ready(pn532_dev_t *dev)
+{
+    spi_transaction_t t = {
+        .flags   = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+        .length  = 16,
+        .tx_data = { PN532_SPI_STATUS_READ, 0x00 },
+    };
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = spi_device_polling_transmit(dev->bus_handle, &t);
+    pn532_transport_record(dev, start, ret == ESP_OK);
+    return (ret == ESP_OK) && (t.rx_data[1] & PN532_I2C_READY);
+}
+
+const pn532_transport_ops_t pn532_spi_transport = {
+    .name     = "SPI",
+    .init     = spi_init,
+    .writev   = spi_writev,
+    .read     = spi_read,
+    .is_ready = spi_is_ready,
+};
@@ -0,0 +1,87 @@
+/**
+ * PN532 driver internal transport layer (I2C, SPI, HSU).
+ * Not part of the public API; used by pn532.c only.
+ *
+ * Frame building, ACK and response parsing live in pn532.c and are shared;
+ * a backend only moves bytes. Reads keep the I2C shape (doc §7.2): buf[0] is
+ * the ready byte and buf[1..len-1] the frame, so the parser is bus-agnostic.
+ */
+
+#ifndef PN532_TRANSPORT_H
+#define PN532_TRANSPORT_H
+
+#include "pn532.h"
+#include "esp_timer.h"
+#include <stddef.h>
+
+/* Pieces per gathered write: frame header, up to two parameter blocks, trailer */
+#define PN532_IOV_MAX 4
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+} pn532_iovec_t;
+
+typedef struct pn532_transport_ops {
+    const char *name;
+
+    /* Install/attach the bus for dev. Safe to call again once installed. */
+    pn532_err_t (*init)(pn532_dev_t *dev);
+
+    /* Write the concatenated pieces (at most PN532_IOV_MAX) in one transaction (doc §7.1) */
+    pn532_err_t (*writev)(pn532_dev_t *dev, const pn532_iovec_t *iov, unsigned iovcnt);
+
+    /* Read ready byte + len - 1 frame bytes in one transaction (doc §7.2) */
+    pn532_err_t (*read)(pn532_dev_t *dev, uint8_t *buf, size_t len);
+
+    /* One status check, true if the PN532 has data (doc §7.3) */
+    bool (*is_ready)(pn532_dev_t *dev);
+
+    /* Optional, NULL if unsupported: */
+
+    /* Stream buses only: read len more bytes of the frame being received,
+     * no ready slot. Non-NULL means reads consume data (no NACK re-send). */
+    pn532_err_t (*read_continue)(pn532_dev_t *dev, uint8_t *buf, size_t len);
+
+    /* Stream buses only: bytes received and not read yet, so pn532_process()
+     * can wait until a read will not block (doc §8.4) */
+    size_t (*buffered)(pn532_dev_t *dev);
+
+    /* Block until ready without polling; used when no IRQ line is wired */
+    pn532_err_t (*wait_ready)(pn532_dev_t *dev, uint32_t timeout_ms);
+
+    /* Change the host side bit rate once pending output has drained */
+    pn532_err_t (*set_baud)(pn532_dev_t *dev, uint32_t baud);
+
+    /* Free a stuck bus and reset the host controller (doc §15.4) */
+    pn532_err_t (*recover)(pn532_dev_t *dev);
+} pn532_transport_ops_t;
+
+extern const pn532_transport_ops_t pn532_i2c_transport;
+extern const pn532_transport_ops_t pn532_spi_transport;
+extern const pn532_transport_ops_t pn532_hsu_transport;
+
+/* Write one contiguous buffer (ACK/NACK, wake-up) */
+static inline pn532_err_t pn532_transport_write(pn532_dev_t *dev, const uint8_t *data, size_t len)
+{
+    const pn532_iovec_t iov = { data, len };
+    return dev->transport->writev(dev, &iov, 1);
+}
+
+/* Account one bus transaction started at start_us in dev->transport_stats */
+static inline void pn532_transport_record(pn532_dev_t *dev, int64_t start_us, bool ok)
+{
+    pn532_transport_stats_t *st = &dev->transport_stats;
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+    st->transactions++;
+    st->total_us += us;
+    st->last_us = us;
+    if (us > st->max_us) {
+        st->max_us = us;
+    }
+    if (!ok) {
+        st->errors++;
+    }
+}
+
+#endif /* PN532_TRANSPORT_H */
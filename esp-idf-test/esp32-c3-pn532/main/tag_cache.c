@@ -0,0 +1,184 @@
+/**
+ * Tag content LRU cache.
+ * Entries keep their content back to back in one arena; on insert the arena
+ * is compacted after eviction so free space is always contiguous at the end.
+ */
+
+#include "tag_cache.h"
+#include <string.h>
+
+typedef struct {
+    bool used;
+    uint8_t uid[TAG_CACHE_UID_MAX_LEN];
+    uint8_t uid_len;
+    uint32_t version;
+    uint32_t last_use;   /* LRU stamp from s_clock */
+    size_t offset;       /* Into s_arena */
+    size_t len;
+} cache_entry_t;
+
+static uint8_t s_arena[TAG_CACHE_BUDGET_BYTES];
+static cache_entry_t s_entries[TAG_CACHE_MAX_ENTRIES];
+static size_t s_arena_used = 0;
+static uint32_t s_clock = 0;
+static tag_cache_stats_t s_stats;
+
+static cache_entry_t *find_entry(const uint8_t *uid, uint8_t uid_len)
+{
+    for (unsigned i = 0; i < TAG_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t *e = &s_entries[i];
+        if (e->used && e->uid_len == uid_len && memcmp(e->uid, uid, uid_len) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void remove_entry(cache_entry_t *e)
+{
+    e->used = false;
+    s_stats.entries--;
+    s_stats.bytes_used -= e->len;
+}
+
+/* Slide live content down so all free space is at the end of the arena */
+static void compact_arena(void)
+{
+    size_t write = 0;
+    for (;;) {
+        /* Next live entry by offset at or after write */
+        cache_entry_t *next = NULL;
+        for (unsigned i = 0; i < TAG_CACHE_MAX_ENTRIES; i++) {
+            cache_entry_t *e = &s_entries[i];
+            if (e->used && e->len > 0 && e->offset >= write && (!next || e->offset < next->offset)) {
+                next = e;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        if (next->offset != write) {
+            memmove(s_arena + write, s_arena + next->offset, next->len);
+            next->offset = write;
+        }
+        write += next->len;
+    }
+    s_arena_used = write;
+}
+
+static cache_entry_t *lru_entry(void)
+{
+    cache_entry_t *lru = NULL;
+    for (unsigned i = 0; i < TAG_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t *e = &s_entries[i];
+        if (e->used && (!lru || (int32_t)(e->last_use - lru->last_use) < 0)) {
+            lru = e;
+        }
+    }
+    return lru;
+}
+
+bool tag_cache_lookup(const uint8_t *uid, uint8_t uid_len, uint32_t version,
+                      const uint8_t **data, size_t *len)
+{
+    cache_entry_t *e = find_entry(uid, uid_len);
+    if (e && e->version != version) {
+        remove_entry(e);
+        e = NULL;
+    }
+    if (!e) {
+        s_stats.misses++;
+        return false;
+    }
+    e->last_use = ++s_clock;
+    *data = s_arena + e->offset;
+    *len = e->len;
+    s_stats.hits++;
+    return true;
+}
+
+bool tag_cache_store(const uint8_t *uid, uint8_t uid_len, uint32_t version,
+                     const uint8_t *data, size_t len)
+{
+    if (uid_len > TAG_CACHE_UID_MAX_LEN || len > TAG_CACHE_BUDGET_BYTES) {
+        return false;
+    }
+
+    cache_entry_t *old = find_entry(uid, uid_len);
+    if (old) {
+        remove_entry(old);
+    }
+
+    /* Evict until both a slot and the bytes are available */
+    cache_entry_t *slot = NULL;
+    for (;;) {
+        slot = NULL;
+        for (unsigned i = 0; i < TAG_CACHE_MAX_ENTRIES; i++) {
+            if (!s_entries[i].used) {
+                slot = &s_entries[i];
+                break;
+            }
+        }
+        if (slot && s_stats.bytes_used + len <= TAG_CACHE_BUDGET_BYTES) {
+            break;
+        }
+        cache_entry_t *victim = lru_entry();
+        if (!victim) {
+            break;
+        }
+        remove_entry(victim);
+        s_stats.evictions++;
+    }
+
+    if (s_arena_used + len > TAG_CACHE_BUDGET_BYTES) {
+        compact_arena();
+    }
+
+    slot->used = true;
+    memcpy(slot->uid, uid, uid_len);
+    slot->uid_len = uid_len;
+    slot->version = version;
+    slot->last_use = ++s_clock;
+    slot->offset = s_arena_used;
+    slot->len = len;
+    if (len > 0) {
+        memcpy(s_arena + s_arena_used, data, len);
+    }
+    s_arena_used += len;
+
+    s_stats.entries++;
+    s_stats.bytes_used += len;
+    s_stats.stores++;
+    return true;
+}
+
+void tag_cache_invalidate(const uint8_t *uid, uint8_t uid_len)
+{
+    cache_entry_t *e = find_entry(uid, uid_len);
+    if (e) {
+        remove_entry(e);
+    }
+}
+
+void tag_cache_clear(void)
+{
+    memset(s_entries, 0, sizeof(s_entries));
+    s_arena_used = 0;
+    s_stats.entries = 0;
+    s_stats.bytes_used = 0;
+}
+
+void tag_cache_get_stats(tag_cache_stats_t *stats)
+{
+    if (stats) {
+        *stats = s_stats;
+    }
+}
+
+void tag_cache_reset_stats(void)
+{
+    s_stats.hits = 0;
+    s_stats.misses = 0;
+    s_stats.evictions = 0;
+    s_stats.stores = 0;
+}
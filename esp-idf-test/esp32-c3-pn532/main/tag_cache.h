@@ -0,0 +1,64 @@
+/**
+ * UID-keyed LRU cache of decoded tag content (NDEF messages).
+ * A hit lets the app skip the tag memory read entirely.
+ * Fixed byte budget, no heap; pure C so it also builds on the host.
+ */
+
+#ifndef TAG_CACHE_H
+#define TAG_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TAG_CACHE_BUDGET_BYTES  2048   /* Content bytes held across all entries */
+#define TAG_CACHE_MAX_ENTRIES   16
+#define TAG_CACHE_UID_MAX_LEN   10
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t stores;
+    size_t bytes_used;
+    unsigned entries;
+} tag_cache_stats_t;
+
+/**
+ * Look up content for uid. version is an optional tag-side counter or hash
+ * (0 when keyed on UID only); a stored entry with a different version is
+ * dropped and counted as a miss. On a hit *data points into the cache and
+ * stays valid until the next tag_cache_store()/tag_cache_clear().
+ */
+bool tag_cache_lookup(const uint8_t *uid, uint8_t uid_len, uint32_t version,
+                      const uint8_t **data, size_t *len);
+
+/**
+ * Store (or replace) content for uid, evicting least recently used entries
+ * until it fits. Returns false if len exceeds TAG_CACHE_BUDGET_BYTES.
+ */
+bool tag_cache_store(const uint8_t *uid, uint8_t uid_len, uint32_t version,
+                     const uint8_t *data, size_t len);
+
+/**
+ * Drop the entry for uid, if any.
+ */
+void tag_cache_invalidate(const uint8_t *uid, uint8_t uid_len);
+
+/**
+ * Drop all entries (counters are kept).
+ */
+void tag_cache_clear(void);
+
+void tag_cache_get_stats(tag_cache_stats_t *stats);
+void tag_cache_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TAG_CACHE_H */